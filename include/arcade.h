@@ -14,24 +14,25 @@
  * Linux (X11), making it ideal for simple games like Flappy Bird or Pong.
  *
  * Features:
- * - Window creation and event handling.
+ * - Window creation and event handling (or headless offscreen rendering).
  * - Support for color-based and image-based sprites with animation.
  * - Keyboard input processing with single-press detection.
  * - Pixel buffer rendering for sprites and text.
- * - WAV audio playback.
+ * - WAV audio playback through an in-process mixer.
  * - Image flipping and rotation.
  *
  * Platforms:
  * - Windows: Uses Win32 API (GDI for rendering, winmm for audio).
- * - Linux: Uses X11 for rendering and aplay for audio.
+ * - Linux: Uses X11 for rendering (MIT-SHM when available) and ALSA for audio.
  *
  * Dependencies:
  * Linux:
  * - libX11: For window creation and rendering.
+ * - libXext: For MIT-SHM shared memory presentation (omit with -DARCADE_NO_XSHM).
  * - libm: For mathematical functions (used by STB libraries).
  * - STB libraries (stb_image.h, stb_image_write.h, stb_image_resize2.h): For
  *   image loading, writing, and resizing.
- * - aplay: For WAV audio playback (part of alsa-utils).
+ * - libasound (optional): Loaded at run time for audio output; libdl to load it.
  * Windows:
  * - gdi32: For window rendering.
  * - winmm: For WAV audio playback.
@@ -39,7 +40,11 @@
  *
  * Compilation:
  * Linux:
- *   gcc -o game game.c arcade.c -lX11 -lm
+ *   gcc -o game game.c arcade.c -lX11 -lXext -lm -lpthread -ldl
+ *   gcc -o game game.c arcade.c -DARCADE_NO_XSHM -lX11 -lm -lpthread -ldl  (without MIT-SHM)
+ * Options:
+ * - ARCADE_NO_SIMD: Use only the portable scalar pixel loops. By default,
+ *   SSE2/AVX2 kernels are selected at startup from CPUID on x86 GCC/Clang builds.
  * Windows:
  *   gcc -o game game.c arcade.c -lgdi32 -lwinmm
  *
@@ -93,13 +98,44 @@
  * Values:
  * - SPRITE_COLOR (0): For ArcadeSprite (color-based, solid rectangle).
  * - SPRITE_IMAGE (1): For ArcadeImageSprite (image-based, loaded from file).
+ * - SPRITE_AFFINE (2): For ArcadeAffineSprite (image drawn scaled and rotated).
  * Example:
  *   arcade_add_sprite_to_group(&group, (ArcadeAnySprite){.sprite = my_sprite}, SPRITE_COLOR);
  */
 enum
 {
     SPRITE_COLOR = 0, /* Color-based sprite (ArcadeSprite) */
-    SPRITE_IMAGE = 1  /* Image-based sprite (ArcadeImageSprite) */
+    SPRITE_IMAGE = 1, /* Image-based sprite (ArcadeImageSprite) */
+    SPRITE_AFFINE = 2 /* Scaled/rotated image sprite (ArcadeAffineSprite) */
+};
+
+/* Sampling filters for ArcadeAffineSprite.
+ * Values:
+ * - ARCADE_FILTER_NEAREST (0): Nearest source pixel; sharp, fastest.
+ * - ARCADE_FILTER_BILINEAR (1): Blend of the four nearest pixels; smooth when scaled or rotated.
+ */
+enum
+{
+    ARCADE_FILTER_NEAREST = 0, /* Nearest source pixel */
+    ARCADE_FILTER_BILINEAR = 1 /* Bilinear interpolation */
+};
+
+/* Presentation path identifiers.
+ * Returned by arcade_present_mode() to report how frames reach the window.
+ * Values:
+ * - ARCADE_PRESENT_BLIT (0): Frame is copied through the window system
+ *   (XPutImage on Linux, BitBlt on Windows).
+ * - ARCADE_PRESENT_XSHM (1): Frame is shared with the X server via MIT-SHM
+ *   (XShmPutImage), avoiding a copy through the X socket.
+ * - ARCADE_PRESENT_NONE (2): Headless mode; frames stay in the pixel buffer.
+ * Example:
+ *   printf("Present path: %s\n", arcade_present_mode() == ARCADE_PRESENT_XSHM ? "XShm" : "blit");
+ */
+enum
+{
+    ARCADE_PRESENT_BLIT = 0, /* Copy through the window system (XPutImage/BitBlt) */
+    ARCADE_PRESENT_XSHM = 1, /* Shared memory presentation (MIT-SHM, Linux only) */
+    ARCADE_PRESENT_NONE = 2  /* Headless, nothing is presented */
 };
 
 /* =========================================================================
@@ -231,6 +267,24 @@ typedef struct
     int active;          /* Active state (1 = active, 0 = inactive) */
 } ArcadeSprite;
 
+/*
+ * ArcadeImageAsset: Decoded image shared by sprites loaded from the same file
+ * at the same size. Opaque; managed by the asset cache.
+ */
+typedef struct ArcadeImageAsset ArcadeImageAsset;
+
+/* Orientation flags for ArcadeImageSprite.orientation: either flip, both, or neither,
+ * plus at most one rotation. Flips are applied first, then the clockwise rotation. */
+enum
+{
+    ARCADE_ORIENT_NONE = 0,       /* Drawn as loaded */
+    ARCADE_ORIENT_FLIP_H = 1,     /* Mirror left to right */
+    ARCADE_ORIENT_FLIP_V = 2,     /* Mirror top to bottom */
+    ARCADE_ORIENT_ROTATE_90 = 4,  /* Quarter turn clockwise */
+    ARCADE_ORIENT_ROTATE_180 = 8, /* Half turn */
+    ARCADE_ORIENT_ROTATE_270 = 12 /* Quarter turn counter-clockwise */
+};
+
 /*
  * ArcadeImageSprite: Represents an image-based sprite loaded from a file.
  * Used for detailed graphics like characters, enemies, or backgrounds.
@@ -238,24 +292,40 @@ typedef struct
  * - x, y: Position (top-left corner) in window coordinates (pixels, float).
  * - width, height: Size of the sprite (pixels, float, set from image dimensions).
  * - vy, vx: Vertical and horizontal velocity (pixels per frame, float).
- * - pixels: Pixel data (RGBA, 32-bit per pixel, dynamically allocated).
+ * - pixels: Pixel data (premultiplied ARGB, 0xAARRGGBB, 32-bit per pixel, dynamically allocated).
  * - image_width, image_height: Pixel dimensions of the image (int).
  * - active: State (1 = active, 0 = inactive, ignored in rendering/collisions).
+ * - opaque_rows: Per-row opacity flags (image_height entries, or NULL); rows flagged 1 are
+ *   copied without blending. Filled in by the loaders; leave NULL for hand-made pixels.
+ * - asset: Cached image the pixels belong to (NULL if the caller owns the pixels).
+ * - stride: Distance between the starts of two pixel rows, in pixels (0 = image_width).
+ *   Atlas sprites point into a shared page, so their stride is the page width.
+ * - orientation: ARCADE_ORIENT_* flags applied while drawing (0 = as loaded). Rotations
+ *   of 90/270 swap the on-screen size; see arcade_set_image_sprite_orientation.
  * Example:
  *   ArcadeImageSprite player = arcade_create_image_sprite(100.0f, 100.0f, 50.0f, 50.0f, "player.png");
  *   arcade_move_image_sprite(&player, 0.1f, 600);
  * Notes:
- * - Pixel data must be freed with arcade_free_image_sprite to avoid memory leaks.
+ * - Each sprite holds a reference to its pixels; release it with
+ *   arcade_release_image_sprite (or arcade_free_image_sprite) to avoid memory leaks.
+ * - Loaded pixels are shared with other sprites of the same file and size;
+ *   treat them as read-only.
  * - Supports PNG files (via STB libraries); other formats may work but are untested.
+ * - Pixels are drawn with source-over alpha blending; color channels must already be
+ *   multiplied by alpha (loaders do this), so a fully transparent pixel is 0.
  */
 typedef struct
 {
     float x, y;                    /* Position (pixels, float) */
     float width, height;           /* Size (pixels, float) */
     float vy, vx;                  /* Velocity (pixels per frame, float) */
-    uint32_t *pixels;              /* Pixel data (RGBA, 32-bit) */
+    uint32_t *pixels;              /* Pixel data (premultiplied ARGB, 32-bit) */
     int image_width, image_height; /* Image dimensions (pixels, int) */
     int active;                    /* Active state (1 = active, 0 = inactive) */
+    uint8_t *opaque_rows;          /* Per-row flag: 1 if every pixel is opaque (optional) */
+    ArcadeImageAsset *asset;       /* Shared image owning pixels, or NULL */
+    int stride;                    /* Pixels per row of pixel data (0 = image_width) */
+    int orientation;               /* ARCADE_ORIENT_* flags applied while drawing */
 } ArcadeImageSprite;
 
 /*
@@ -274,6 +344,8 @@ typedef struct
  * Notes:
  * - All frames must have the same dimensions.
  * - Free with arcade_free_animated_sprite to avoid memory leaks.
+ * - Every frame carries its own position, so moving one costs O(frame_count);
+ *   for many copies of one animation use ArcadeAnimClip and ArcadeAnimInstance.
  */
 typedef struct
 {
@@ -284,23 +356,88 @@ typedef struct
     int frame_counter;         /* Animation progress counter */
 } ArcadeAnimatedSprite;
 
+/*
+ * ArcadeAffineSprite: An image sprite drawn with its own scale, rotation and pivot.
+ * The transform is applied while drawing, so it can change every frame without
+ * reloading or allocating.
+ * Fields:
+ * - image: Sprite whose pixels are drawn; image.x, image.y is where its top-left
+ *   corner sits when unscaled and unrotated. Its orientation flags are ignored.
+ * - scale_x, scale_y: Scale factors (1 = load size; negative values mirror).
+ * - angle: Clockwise rotation in degrees.
+ * - origin_x, origin_y: Pivot for scaling and rotation, in image pixels from the top-left.
+ * - filter: ARCADE_FILTER_NEAREST or ARCADE_FILTER_BILINEAR.
+ * Example:
+ *   ArcadeAffineSprite ship = arcade_create_affine_sprite(arcade_create_image_sprite(300.0f, 200.0f, 64.0f, 64.0f, "ship.png"));
+ *   ship.angle += 2.0f; // Spin a little every frame
+ *   ArcadeAnySprite any = {.affine_sprite = ship};
+ * Notes:
+ * - Render with type SPRITE_AFFINE.
+ * - Scales below 1/1024 are not drawn.
+ * - Images wider or taller than 32767 pixels cannot be drawn this way.
+ */
+typedef struct
+{
+    ArcadeImageSprite image;  /* Pixels and untransformed position */
+    float scale_x, scale_y;   /* Scale factors (1 = load size) */
+    float angle;              /* Clockwise rotation (degrees) */
+    float origin_x, origin_y; /* Pivot (image pixels from the top-left) */
+    int filter;               /* ARCADE_FILTER_NEAREST or ARCADE_FILTER_BILINEAR */
+} ArcadeAffineSprite;
+
+/*
+ * ArcadeAnimClip: Frames and timing of an animation, shared by any number of instances.
+ * Opaque; create with arcade_create_anim_clip and free with arcade_free_anim_clip.
+ */
+typedef struct ArcadeAnimClip ArcadeAnimClip;
+
+/*
+ * ArcadeAnimInstance: One on-screen copy of an animation clip.
+ * Holds only per-instance state, so thousands of animated enemies stay small
+ * and cheap to update.
+ * Fields:
+ * - clip: Shared clip (frames and timing).
+ * - x, y: Position (top-left corner) in window coordinates (pixels, float).
+ * - vy, vx: Vertical and horizontal velocity (pixels per frame, float).
+ * - current_frame: Index of the frame being shown.
+ * - frame_counter: Ticks since the last frame change.
+ * - active: State (1 = active, 0 = inactive, ignored in rendering/collisions).
+ * Example:
+ *   ArcadeAnimClip *flap = arcade_create_anim_clip(50.0f, 50.0f, frames, 3, 5);
+ *   ArcadeAnimInstance bird = arcade_create_anim_instance(flap, 100.0f, 100.0f);
+ *   arcade_move_anim_instance(&bird, 0.1f, 600);
+ * Notes:
+ * - Instances own nothing; free the clip once its instances are no longer used.
+ */
+typedef struct
+{
+    const ArcadeAnimClip *clip; /* Shared frames and timing */
+    float x, y;                 /* Position (pixels, float) */
+    float vy, vx;               /* Velocity (pixels per frame, float) */
+    int current_frame;          /* Current frame index */
+    int frame_counter;          /* Animation progress counter */
+    int active;                 /* Active state (1 = active, 0 = inactive) */
+} ArcadeAnimInstance;
+
 /*
  * ArcadeAnySprite: Union to handle both color and image-based sprites.
  * Allows SpriteGroup to store either ArcadeSprite or ArcadeImageSprite.
  * Fields:
  * - sprite: ArcadeSprite (color-based).
  * - image_sprite: ArcadeImageSprite (image-based).
+ * - affine_sprite: ArcadeAffineSprite (image-based, scaled and rotated).
  * Example:
  *   ArcadeAnySprite any_sprite = {.image_sprite = player};
  *   arcade_add_sprite_to_group(&group, any_sprite, SPRITE_IMAGE);
  * Notesmong:
- * - Use with SPRITE_COLOR or SPRITE_IMAGE to specify the type.
+ * - Use with SPRITE_COLOR, SPRITE_IMAGE or SPRITE_AFFINE to specify the type.
  * - Ensures type safety when rendering mixed sprite types.
  */
 typedef union
 {
-    ArcadeSprite sprite;            /* Color-based sprite */
-    ArcadeImageSprite image_sprite; /* Image-based sprite */
+    ArcadeSprite sprite;              /* Color-based sprite */
+    ArcadeImageSprite image_sprite;   /* Image-based sprite */
+    ArcadeAffineSprite affine_sprite; /* Scaled/rotated image sprite */
 } ArcadeAnySprite;
 
 /*
@@ -328,6 +465,26 @@ typedef struct
     int capacity;             /* Maximum sprite count */
 } SpriteGroup;
 
+/*
+ * ArcadeContext: Opaque handle to one independent arcade instance.
+ * Holds everything the library tracks between calls: the window or offscreen
+ * pixel buffer, key states, the frame counter and the delta-time clock.
+ * Example:
+ *   ArcadeContext *ctx = arcade_context_create();
+ *   arcade_ctx_init_headless(ctx, 320, 240, 0x000000);
+ *   while (arcade_ctx_running(ctx) && arcade_ctx_update(ctx)) {
+ *       arcade_ctx_render_group(ctx, &group);
+ *   }
+ *   arcade_context_destroy(ctx);
+ * Notes:
+ * - Functions without a ctx parameter (arcade_init, arcade_update, ...) operate
+ *   on a built-in default context (see arcade_default_context).
+ * - Separate contexts share no state, so each can run on its own thread.
+ * - Sprites and groups are not tied to a context; decoded images can be drawn
+ *   by any context.
+ */
+typedef struct ArcadeContext ArcadeContext;
+
 /* =========================================================================
  * Core Functions
  * ========================================================================= */
@@ -352,12 +509,40 @@ typedef struct
  * - Call once at program start.
  * - Check return value for error handling.
  * - Window is non-resizable and centered on the screen.
+ * - If the ARCADE_HEADLESS environment variable is set (and not "0"), behaves
+ *   like arcade_init_headless and opens no window.
  */
 int arcade_init(int window_width, int window_height, const char *window_title, uint32_t bg_color);
 
+/*
+ * arcade_init_headless: Initializes the arcade environment without a window.
+ * Allocates only the pixel buffer, for servers, CI and renderer benchmarks.
+ * Parameters:
+ * - width: Width of the offscreen frame (pixels).
+ * - height: Height of the offscreen frame (pixels).
+ * - bg_color: Background color (0xRRGGBB).
+ * Returns:
+ * - 0 on success.
+ * - Non-zero on failure (e.g., pixel buffer allocation failed).
+ * Example:
+ *   arcade_init_headless(800, 600, 0x000000);
+ *   arcade_inject_key(a_space, 1, 10); // Press space on frame 10
+ *   while (arcade_running() && arcade_update() && arcade_frame_count() < 10000) {
+ *       arcade_render_group(&group);
+ *   }
+ *   arcade_quit();
+ * Notes:
+ * - No display connection is opened, so no X server or Xvfb is needed.
+ * - arcade_update applies only injected input (see arcade_inject_key).
+ * - arcade_render_scene draws into the pixel buffer and skips presentation.
+ * - Text is drawn into the pixel buffer like in a window.
+ * - arcade_present_mode returns ARCADE_PRESENT_NONE.
+ */
+int arcade_init_headless(int width, int height, uint32_t bg_color);
+
 /*
  * arcade_quit: Cleans up the arcade environment, freeing resources.
- * Closes the window, releases fonts, and frees pixel buffers.
+ * Closes the window, frees pixel buffers and cached text layouts.
  * Parameters: None.
  * Returns: None.
  * Example:
@@ -382,6 +567,8 @@ void arcade_quit(void);
  * Notes:
  * - Call once per frame in the game loop.
  * - Handles platform-specific events (Win32 messages, X11 events).
+ * - If no scene was rendered since the last call, presents text queued with
+ *   arcade_render_text so text-only screens still appear.
  */
 int arcade_update(void);
 
@@ -402,6 +589,21 @@ int arcade_update(void);
  */
 int arcade_running(void);
 
+/*
+ * arcade_frame_count: Returns the number of frames processed so far.
+ * Incremented once by every arcade_update call.
+ * Parameters: None.
+ * Returns: Current frame counter (0 before the first arcade_update).
+ * Example:
+ *   if (arcade_frame_count() >= 600) {
+ *       arcade_set_running(0); // Stop a headless run after 600 frames
+ *   }
+ * Notes:
+ * - Same counter used by arcade_render_text_centered_blink.
+ * - Use it to schedule injected input with arcade_inject_key.
+ */
+int arcade_frame_count(void);
+
 /*
  * arcade_set_running: Sets the running state of the game.
  * Allows manual control over the game loop (e.g., to exit programmatically).
@@ -513,6 +715,28 @@ int arcade_key_pressed_once(unsigned int key_val);
  */
 void arcade_clear_keys(void);
 
+/*
+ * arcade_inject_key: Queues a scripted key press or release.
+ * Lets tests and headless simulations drive input without a keyboard.
+ * Parameters:
+ * - key_val: Key code (e.g., a_space, a_left).
+ * - pressed: 1 for key down, 0 for key up.
+ * - frame: Frame count at which to apply the event; it is applied by the
+ *   arcade_update call that brings arcade_frame_count() to this value.
+ *   Values at or below the current count apply on the next arcade_update.
+ * Returns:
+ * - 0 on success.
+ * - Non-zero on failure (e.g., queue allocation failed).
+ * Example:
+ *   arcade_inject_key(a_right, 1, 1);  // Hold right from frame 1
+ *   arcade_inject_key(a_right, 0, 60); // Release on frame 60
+ * Notes:
+ * - Works with both the windowed and headless backends.
+ * - Events due on the same frame are applied in the order they were queued.
+ * - Pending events are discarded by arcade_quit.
+ */
+int arcade_inject_key(unsigned int key_val, int pressed, int frame);
+
 /* =========================================================================
  * Sprite Management
  * ========================================================================= */
@@ -552,6 +776,40 @@ void arcade_move_sprite(ArcadeSprite *sprite, float gravity, int window_height);
  */
 void arcade_move_image_sprite(ArcadeImageSprite *sprite, float gravity, int window_height);
 
+/*
+ * arcade_set_image_sprite_orientation: Sets how a sprite's pixels are flipped and rotated on screen.
+ * The renderer applies the orientation while drawing, so every orientation shares the
+ * same pixels; no image is copied or reloaded.
+ * Parameters:
+ * - sprite: Pointer to ArcadeImageSprite to change.
+ * - orientation: ARCADE_ORIENT_* flags, e.g. ARCADE_ORIENT_FLIP_H | ARCADE_ORIENT_ROTATE_90.
+ * Returns: None.
+ * Example:
+ *   // Face left when moving left
+ *   arcade_set_image_sprite_orientation(&player, player.vx < 0 ? ARCADE_ORIENT_FLIP_H : ARCADE_ORIENT_NONE);
+ * Notes:
+ * - Swaps width and height when going between upright and quarter-turned, so
+ *   collisions keep matching what is drawn.
+ * - Turned or mirrored rows cost a little more to draw than upright ones.
+ */
+void arcade_set_image_sprite_orientation(ArcadeImageSprite *sprite, int orientation);
+
+/*
+ * arcade_create_affine_sprite: Wraps an image sprite so it can be scaled and rotated.
+ * Parameters:
+ * - image: Sprite to draw; the affine sprite takes over its pixel reference.
+ * Returns:
+ * - ArcadeAffineSprite at scale 1, angle 0, pivoting about the image center, nearest filtering.
+ * Example:
+ *   ArcadeAffineSprite coin = arcade_create_affine_sprite(arcade_create_image_sprite(100.0f, 100.0f, 32.0f, 32.0f, "coin.png"));
+ *   coin.scale_x = coin.scale_y = 2.0f;
+ *   coin.filter = ARCADE_FILTER_BILINEAR;
+ * Notes:
+ * - Release with arcade_release_image_sprite(&sprite.image).
+ * - Until the transform changes it draws exactly like the image sprite.
+ */
+ArcadeAffineSprite arcade_create_affine_sprite(ArcadeImageSprite image);
+
 /*
  * arcade_check_collision: Checks for collision between two color-based sprites.
  * Uses axis-aligned bounding box (AABB) collision detection.
@@ -588,10 +846,34 @@ int arcade_check_collision(ArcadeSprite *a, ArcadeSprite *b);
  *   }
  * Notes:
  * - Same logic as arcade_check_collision but for image sprites.
- * - Does not check pixel-level collision (only bounding boxes).
+ * - Does not check pixel-level collision (only bounding boxes); see arcade_check_pixel_collision.
  */
 int arcade_check_image_collision(ArcadeImageSprite *a, ArcadeImageSprite *b);
 
+/*
+ * arcade_check_pixel_collision: Checks whether two image sprites overlap on solid pixels.
+ * Parameters:
+ * - a: Pointer to first ArcadeImageSprite.
+ * - b: Pointer to second ArcadeImageSprite.
+ * Returns:
+ * - 1 if a pixel of a and a pixel of b with alpha >= 128 land on the same screen pixel.
+ * - 0 if not, or if either sprite is null or inactive.
+ * Example:
+ *   if (arcade_check_image_collision(&player, &spikes) && arcade_check_pixel_collision(&player, &spikes)) {
+ *       // Hit only when the spikes themselves are touched
+ *   }
+ * Notes:
+ * - Compares the pixels as drawn: positions are truncated like the renderer, and
+ *   orientation flags are honored.
+ * - Loaded images get a 1-bit-per-pixel mask at load time; atlas and pack sprites get
+ *   theirs on first use. The test only visits the rows of the overlapping area, 64
+ *   pixels at a time, so it costs little more than the box test.
+ * - Quarter-turned sprites and sprites with caller-owned pixels (asset == NULL) are
+ *   tested pixel by pixel instead, which is slower.
+ * - Masks are counted in arcade_asset_stats().bytes_resident.
+ */
+int arcade_check_pixel_collision(const ArcadeImageSprite *a, const ArcadeImageSprite *b);
+
 /*
  * arcade_create_image_sprite: Creates an image-based sprite from a file.
  * Loads and resizes an image (e.g., PNG) to the specified dimensions.
@@ -608,26 +890,257 @@ int arcade_check_image_collision(ArcadeImageSprite *a, ArcadeImageSprite *b);
  *   }
  * Notes:
  * - Uses STB libraries to load and resize images.
- * - Pixel data is dynamically allocated; free with arcade_free_image_sprite.
+ * - Pixels are converted to premultiplied alpha at load time.
+ * - Images are cached by (filename, w, h): creating 500 sprites from one file
+ *   decodes it once and shares a single copy of the pixels.
+ * - Release with arcade_release_image_sprite (or arcade_free_image_sprite).
  * - Sets active = 1 on success, 0 on failure.
  */
 ArcadeImageSprite arcade_create_image_sprite(float x, float y, float w, float h, const char *filename);
 
+/*
+ * arcade_retain_image_sprite: Copies a sprite and takes another reference to its pixels.
+ * Parameters:
+ * - sprite: Sprite to copy.
+ * Returns:
+ * - Copy sharing the same pixels; release it independently.
+ * Example:
+ *   ArcadeImageSprite enemy = arcade_retain_image_sprite(&enemy_template);
+ *   enemy.x = 300.0f;
+ *   ...
+ *   arcade_release_image_sprite(&enemy);
+ * Notes:
+ * - A plain struct copy does not take a reference; only release sprites that
+ *   were created or retained.
+ * - Sprites whose pixels the caller allocated (asset == NULL) are copied
+ *   without a reference; release only one of the copies.
+ */
+ArcadeImageSprite arcade_retain_image_sprite(const ArcadeImageSprite *sprite);
+
+/*
+ * arcade_release_image_sprite: Drops a sprite's reference to its pixels.
+ * The shared image is freed when its last sprite is released.
+ * Parameters:
+ * - sprite: Pointer to ArcadeImageSprite to release.
+ * Returns: None.
+ * Example:
+ *   ArcadeImageSprite player = arcade_create_image_sprite(100.0f, 100.0f, 50.0f, 50.0f, "player.png");
+ *   arcade_release_image_sprite(&player);
+ * Notes:
+ * - Safe to call on null or already-released sprites.
+ * - Sets pixels = NULL, asset = NULL, image_width = 0, image_height = 0, active = 0.
+ * - Pixels not owned by the cache (asset == NULL) are freed with free().
+ */
+void arcade_release_image_sprite(ArcadeImageSprite *sprite);
+
 /*
  * arcade_free_image_sprite: Frees the pixel data of an image-based sprite.
- * Releases memory allocated for the sprite’s pixels.
+ * Same as arcade_release_image_sprite; kept for existing code.
  * Parameters:
  * - sprite: Pointer to ArcadeImageSprite to free.
  * Returns: None.
  * Example:
- *   ArcadeImageSprite player = arcade_create_image_sprite(100.0f, 100.0f, 50.0f, 50.0f, "player.png");
  *   arcade_free_image_sprite(&player);
- * Notes:
- * - Safe to call on null or already-freed sprites.
- * - Sets pixels = NULL, image_width = 0, image_height = 0, active = 0.
  */
 void arcade_free_image_sprite(ArcadeImageSprite *sprite);
 
+/*
+ * ArcadeAssetStats: Counters of the image asset cache.
+ * Fields:
+ * - hits: Image loads served from the cache.
+ * - misses: Image loads that had to decode the file.
+ * - bytes_resident: Memory held by cached images and atlas pages, with their collision masks (bytes).
+ * - assets: Number of cached images, atlas pages and open asset packs.
+ */
+typedef struct
+{
+    unsigned long hits;    /* Loads served from the cache */
+    unsigned long misses;  /* Loads that decoded the file */
+    size_t bytes_resident; /* Memory held by cached images and atlas pages (bytes) */
+    int assets;            /* Images, atlas pages and packs currently alive */
+} ArcadeAssetStats;
+
+/*
+ * arcade_asset_stats: Reports image asset cache statistics.
+ * Parameters: None.
+ * Returns:
+ * - Snapshot of the cache counters.
+ * Example:
+ *   ArcadeAssetStats stats = arcade_asset_stats();
+ *   printf("%lu hits, %lu misses, %zu bytes\n", stats.hits, stats.misses, stats.bytes_resident);
+ * Notes:
+ * - Images stay cached while at least one sprite references them.
+ */
+ArcadeAssetStats arcade_asset_stats(void);
+
+/*
+ * ArcadeAtlas: Texture atlas packing many images into a few large pages.
+ * Opaque; create with arcade_create_atlas and free with arcade_free_atlas.
+ */
+typedef struct ArcadeAtlas ArcadeAtlas;
+
+/*
+ * arcade_create_atlas: Creates an empty texture atlas.
+ * Parameters:
+ * - page_width, page_height: Maximum size of each page (pixels, int).
+ * Returns:
+ * - Pointer to the atlas, or NULL on failure.
+ * Example:
+ *   ArcadeAtlas *atlas = arcade_create_atlas(1024, 1024);
+ * Notes:
+ * - page_width is rounded up so every page row starts on a 64-byte boundary.
+ * - Pages are only as tall as the images packed into them need.
+ */
+ArcadeAtlas *arcade_create_atlas(int page_width, int page_height);
+
+/*
+ * arcade_atlas_add_image: Queues an image for packing into the atlas.
+ * Parameters:
+ * - atlas: Atlas to add to.
+ * - filename: Path to the image file (e.g., "sprites/coin.png").
+ * - w, h: Size to resize the image to (pixels, int).
+ * Returns:
+ * - Index of the image in the atlas, or -1 on failure.
+ * Example:
+ *   int coin = arcade_atlas_add_image(atlas, "coin.png", 16, 16);
+ * Notes:
+ * - The file is not read until arcade_build_atlas.
+ * - Images larger than a page are rejected.
+ */
+int arcade_atlas_add_image(ArcadeAtlas *atlas, const char *filename, int w, int h);
+
+/*
+ * arcade_build_atlas: Decodes all queued images and packs them into pages.
+ * Parameters:
+ * - atlas: Atlas to build.
+ * Returns:
+ * - 0 on success, 1 on failure (e.g., an image cannot be loaded).
+ * Example:
+ *   if (arcade_build_atlas(atlas) != 0) {
+ *       fprintf(stderr, "Failed to build atlas\n");
+ *   }
+ * Notes:
+ * - Uses a skyline packer, tallest images first; a new page is opened when
+ *   no existing page has room.
+ * - Each page is a single pixel allocation shared by its sprites.
+ * - Rebuilding after adding more images creates new pages; sprites created
+ *   from the old pages keep them alive until released.
+ */
+int arcade_build_atlas(ArcadeAtlas *atlas);
+
+/*
+ * arcade_atlas_page_count: Returns the number of pages of a built atlas.
+ * Parameters:
+ * - atlas: Atlas to query.
+ * Returns:
+ * - Page count (0 if the atlas is not built).
+ * Example:
+ *   printf("%d atlas pages\n", arcade_atlas_page_count(atlas));
+ */
+int arcade_atlas_page_count(const ArcadeAtlas *atlas);
+
+/*
+ * arcade_create_atlas_sprite: Creates an image sprite showing one atlas image.
+ * Parameters:
+ * - atlas: Built atlas.
+ * - index: Image index returned by arcade_atlas_add_image.
+ * - x, y: Initial position (pixels, float).
+ * Returns:
+ * - ArcadeImageSprite referencing the image inside its page, or an empty sprite on failure.
+ * Example:
+ *   ArcadeImageSprite coin_sprite = arcade_create_atlas_sprite(atlas, coin, 200.0f, 150.0f);
+ *   ...
+ *   arcade_release_image_sprite(&coin_sprite);
+ * Notes:
+ * - The sprite's pixels point into the page (stride = page width); treat them as read-only.
+ * - Each sprite holds a reference to its page; release it like any image sprite.
+ */
+ArcadeImageSprite arcade_create_atlas_sprite(ArcadeAtlas *atlas, int index, float x, float y);
+
+/*
+ * arcade_free_atlas: Frees an atlas.
+ * Parameters:
+ * - atlas: Atlas to free (may be NULL).
+ * Returns: None.
+ * Example:
+ *   arcade_free_atlas(atlas);
+ * Notes:
+ * - Pages still used by sprites stay alive until those sprites are released.
+ */
+void arcade_free_atlas(ArcadeAtlas *atlas);
+
+/*
+ * ArcadePack: Memory-mapped file of ready-to-draw images.
+ * Opaque; open with arcade_open_pack and close with arcade_close_pack.
+ */
+typedef struct ArcadePack ArcadePack;
+
+/*
+ * arcade_write_pack: Bakes images into an asset pack.
+ * Decodes, resizes and premultiplies each image once and stores the result,
+ * so loading from the pack needs no decoding at all.
+ * Parameters:
+ * - pack_path: Output file (e.g., "assets/level1.pack").
+ * - filenames: Image files; each is stored under its path as given.
+ * - widths, heights: Size to store each image at (pixels, int).
+ * - count: Number of images.
+ * Returns:
+ * - 0 on success, 1 on failure (no partial pack is left behind).
+ * Example:
+ *   const char *files[] = {"player.png", "coin.png"};
+ *   int widths[] = {50, 16}, heights[] = {50, 16};
+ *   arcade_write_pack("game.pack", files, widths, heights, 2);
+ * Notes:
+ * - Usually run offline through the arcade_pack tool (tools/arcade_pack.c).
+ * - Each file may appear once; pixels are stored in the byte order of the
+ *   machine that wrote the pack.
+ */
+int arcade_write_pack(const char *pack_path, const char **filenames, const int *widths, const int *heights, int count);
+
+/*
+ * arcade_open_pack: Maps an asset pack into memory.
+ * Parameters:
+ * - pack_path: Pack file written by arcade_write_pack.
+ * Returns:
+ * - Pointer to the pack, or NULL if it cannot be opened or is malformed.
+ * Example:
+ *   ArcadePack *pack = arcade_open_pack("game.pack");
+ * Notes:
+ * - Nothing is read up front; pages are loaded on first draw and shared by
+ *   every process that maps the same pack.
+ */
+ArcadePack *arcade_open_pack(const char *pack_path);
+
+/*
+ * arcade_create_pack_sprite: Creates an image sprite from an image in a pack.
+ * Parameters:
+ * - pack: Open pack.
+ * - name: Image name (the path it was packed from, e.g., "player.png").
+ * - x, y: Initial position (pixels, float).
+ * Returns:
+ * - ArcadeImageSprite pointing into the pack, or an empty sprite if the name is unknown.
+ * Example:
+ *   ArcadeImageSprite player = arcade_create_pack_sprite(pack, "player.png", 100.0f, 100.0f);
+ * Notes:
+ * - Size comes from the pack; pixels point straight into the mapping.
+ * - Writes to the pixels stay private to the process (copy-on-write).
+ * - Release like any image sprite; the mapping lives until the pack is
+ *   closed and its last sprite is released.
+ */
+ArcadeImageSprite arcade_create_pack_sprite(ArcadePack *pack, const char *name, float x, float y);
+
+/*
+ * arcade_close_pack: Closes an asset pack.
+ * Parameters:
+ * - pack: Pack to close (may be NULL).
+ * Returns: None.
+ * Example:
+ *   arcade_close_pack(pack);
+ * Notes:
+ * - Sprites created from the pack stay valid until released.
+ */
+void arcade_close_pack(ArcadePack *pack);
+
 /*
  * arcade_create_animated_sprite: Creates an animated sprite with multiple frames.
  * Loads a sequence of images for animation (e.g., walking cycle).
@@ -700,64 +1213,452 @@ void arcade_move_animated_sprite(ArcadeAnimatedSprite *anim, float gravity, int
  */
 int arcade_check_animated_collision(ArcadeAnimatedSprite *anim, ArcadeImageSprite *other);
 
-/* =========================================================================
- * Rendering
- * ========================================================================= */
-
 /*
- * arcade_render_scene: Renders a scene with multiple sprites.
- * Draws all sprites to the pixel buffer and updates the window.
+ * arcade_create_anim_clip: Loads the frames of an animation once, for sharing.
  * Parameters:
- * - sprites: Array of ArcadeAnySprite (color or image-based).
- * - count: Number of sprites to render.
- * - types: Array of sprite types (SPRITE_COLOR or SPRITE_IMAGE).
- * Returns: None.
+ * - w, h: Desired width and height for each frame (pixels, float).
+ * - filenames: Array of image file paths (e.g., {"frame1.png", "frame2.png"}).
+ * - frame_count: Number of frames.
+ * - frame_interval: Ticks between frame changes (e.g., 5 for 12 FPS at 60 FPS).
+ * Returns:
+ * - Pointer to the clip, or NULL if any frame fails to load.
  * Example:
- *   ArcadeAnySprite sprites[2] = {{.sprite = platform}, {.image_sprite = player}};
- *   int types[2] = {SPRITE_COLOR, SPRITE_IMAGE};
- *   arcade_render_scene(sprites, 2, types);
+ *   const char *frames[] = {"bird1.png", "bird2.png", "bird3.png"};
+ *   ArcadeAnimClip *flap = arcade_create_anim_clip(50.0f, 50.0f, frames, 3, 5);
  * Notes:
- * - Clears the screen to the background color before rendering.
- * - Uses double buffering (Windows: GDI bitmap, Linux: XImage).
- * - Ignores inactive or null sprites.
+ * - Frames come from the asset cache, so clips of the same files share pixels.
+ * - Prefer clips over ArcadeAnimatedSprite for many copies of one animation.
  */
-void arcade_render_scene(ArcadeAnySprite *sprites, int count, int *types);
+ArcadeAnimClip *arcade_create_anim_clip(float w, float h, const char **filenames, int frame_count, int frame_interval);
 
 /*
- * arcade_render_text: Renders text at a specified position.
- * Draws text using a fixed font (Courier New on Windows, 9x15 on Linux).
+ * arcade_create_anim_clip_from_sprites: Builds a clip from already loaded sprites.
  * Parameters:
- * - text: Null-terminated string to render.
- * - x, y: Position of the text’s top-left corner (pixels, float).
- * - color: Text color (0xRRGGBB, e.g., 0xFFFFFF for white).
- * Returns: None.
+ * - frames: Image sprites to use as frames (e.g., from an atlas or asset pack).
+ * - frame_count: Number of frames.
+ * - frame_interval: Ticks between frame changes.
+ * Returns:
+ * - Pointer to the clip, or NULL on failure (e.g., a frame has no pixels).
  * Example:
- *   arcade_render_text("Score: 10", 10.0f, 10.0f, 0xFFFFFF);
+ *   ArcadeImageSprite frames[2] = {arcade_create_pack_sprite(pack, "coin1.png", 0, 0),
+ *                                  arcade_create_pack_sprite(pack, "coin2.png", 0, 0)};
+ *   ArcadeAnimClip *spin = arcade_create_anim_clip_from_sprites(frames, 2, 8);
  * Notes:
- * - Text is rendered with a transparent background.
- * - Skips rendering if text is null or font is unavailable.
+ * - The clip takes its own reference to each frame; the caller still releases frames.
  */
-void arcade_render_text(const char *text, float x, float y, unsigned int color);
+ArcadeAnimClip *arcade_create_anim_clip_from_sprites(const ArcadeImageSprite *frames, int frame_count, int frame_interval);
 
 /*
- * arcade_render_text_centered: Renders text centered horizontally.
- * Calculates the x-position to center the text based on its width.
+ * arcade_create_anim_clip_from_sheet: Loads an animation from a grid sprite sheet.
+ * The sheet is decoded once and all frames are stored in one contiguous block.
  * Parameters:
- * - text: Null-terminated string to render.
- * - y: Vertical position of the text’s top edge (pixels, float).
- * - color: Text color (0xRRGGBB).
- * Returns: None.
+ * - filename: Path to the sheet image (e.g., "sprites/explosion.png").
+ * - cell_width, cell_height: Size of one grid cell in the sheet (pixels, int).
+ * - frame_count: Number of frames, read left to right, top to bottom (0 = every cell).
+ * - w, h: Desired frame width and height (pixels, float; 0 = cell size).
+ * - frame_interval: Ticks between frame changes.
+ * Returns:
+ * - Pointer to the clip, or NULL on failure.
  * Example:
- *   arcade_render_text_centered("Game Over", 300.0f, 0xFF0000);
+ *   ArcadeAnimClip *boom = arcade_create_anim_clip_from_sheet("explosion.png", 64, 64, 0, 32.0f, 32.0f, 3);
+ */
+ArcadeAnimClip *arcade_create_anim_clip_from_sheet(const char *filename, int cell_width, int cell_height, int frame_count,
+                                                   float w, float h, int frame_interval);
+
+/*
+ * arcade_create_anim_clip_from_rects: Loads an animation from arbitrary rectangles of one image.
+ * Parameters:
+ * - filename: Path to the sheet image.
+ * - rects: frame_count rectangles as x, y, width, height quadruples (pixels, int), e.g.
+ *   the frame list of a texture packer's JSON export.
+ * - frame_count: Number of frames.
+ * - w, h: Desired frame width and height (pixels, float; 0 = size of the first rect).
+ * - frame_interval: Ticks between frame changes.
+ * Returns:
+ * - Pointer to the clip, or NULL on failure (e.g., a rect lies outside the image).
+ * Example:
+ *   int rects[] = {0, 0, 24, 32, 24, 0, 24, 32, 48, 0, 26, 32};
+ *   ArcadeAnimClip *walk = arcade_create_anim_clip_from_rects("hero.png", rects, 3, 24.0f, 32.0f, 6);
  * Notes:
- * - Uses the same font as arcade_render_text.
- * - Skips rendering if text is null or font is unavailable.
+ * - Rects of a different size than w x h are resized to it.
  */
-void arcade_render_text_centered(const char *text, float y, unsigned int color);
+ArcadeAnimClip *arcade_create_anim_clip_from_rects(const char *filename, const int *rects, int frame_count, float w, float h,
+                                                   int frame_interval);
 
 /*
- * arcade_render_text_centered_blink: Renders centered text that blinks.
- * Toggles visibility based on a frame interval.
+ * arcade_create_anim_clip_from_gif: Loads an animated GIF as a clip.
+ * Parameters:
+ * - filename: Path to the GIF file.
+ * - w, h: Desired frame width and height (pixels, float; 0 = GIF size).
+ * Returns:
+ * - Pointer to the clip, or NULL on failure.
+ * Example:
+ *   ArcadeAnimClip *fire = arcade_create_anim_clip_from_gif("fire.gif", 0.0f, 0.0f);
+ * Notes:
+ * - Per-frame GIF delays are kept, converted to ticks at 60 FPS (arcade_sleep(16)).
+ * - All frames are decoded at once into one contiguous block.
+ */
+ArcadeAnimClip *arcade_create_anim_clip_from_gif(const char *filename, float w, float h);
+
+/*
+ * arcade_free_anim_clip: Frees an animation clip.
+ * Parameters:
+ * - clip: Clip to free (may be NULL).
+ * Returns: None.
+ * Example:
+ *   arcade_free_anim_clip(flap);
+ * Notes:
+ * - Instances of the clip must not be used afterwards.
+ */
+void arcade_free_anim_clip(ArcadeAnimClip *clip);
+
+/*
+ * arcade_create_anim_instance: Creates an instance of a clip at a position.
+ * Parameters:
+ * - clip: Shared clip.
+ * - x, y: Initial position (pixels, float).
+ * Returns:
+ * - Instance starting at the first frame (active = 0 if clip is NULL).
+ * Example:
+ *   ArcadeAnimInstance enemies[1000];
+ *   for (int i = 0; i < 1000; i++)
+ *       enemies[i] = arcade_create_anim_instance(flap, i * 8.0f, 50.0f);
+ */
+ArcadeAnimInstance arcade_create_anim_instance(const ArcadeAnimClip *clip, float x, float y);
+
+/*
+ * arcade_move_anim_instance: Moves an instance and advances its animation.
+ * Parameters:
+ * - instance: Instance to update.
+ * - gravity: Gravity acceleration (pixels per frame^2).
+ * - window_height: Height of the window.
+ * Returns: None.
+ * Example:
+ *   arcade_move_anim_instance(&enemies[i], 0.0f, 600);
+ * Notes:
+ * - Same motion as arcade_move_image_sprite; constant time regardless of frame count.
+ * - Ignores inactive or null instances.
+ */
+void arcade_move_anim_instance(ArcadeAnimInstance *instance, float gravity, int window_height);
+
+/*
+ * arcade_anim_instance_sprite: Returns the frame an instance currently shows.
+ * Parameters:
+ * - instance: Instance to query.
+ * Returns:
+ * - Image sprite of the current frame at the instance's position (empty if instance is NULL).
+ * Example:
+ *   ArcadeImageSprite frame = arcade_anim_instance_sprite(&bird);
+ *   arcade_render_scene((ArcadeAnySprite[]){{.image_sprite = frame}}, 1, (int[]){SPRITE_IMAGE});
+ * Notes:
+ * - A view into the clip; do not release it.
+ */
+ArcadeImageSprite arcade_anim_instance_sprite(const ArcadeAnimInstance *instance);
+
+/*
+ * arcade_check_anim_instance_collision: Checks for collision between an instance and an image-based sprite.
+ * Parameters:
+ * - instance: Animation instance.
+ * - other: Pointer to ArcadeImageSprite.
+ * Returns:
+ * - 1 if they collide, 0 otherwise (or if either is null or inactive).
+ * Example:
+ *   if (arcade_check_anim_instance_collision(&enemies[i], &player)) {
+ *       // Handle hit
+ *   }
+ * Notes:
+ * - Uses the current frame's bounding box, like arcade_check_animated_collision.
+ */
+int arcade_check_anim_instance_collision(const ArcadeAnimInstance *instance, ArcadeImageSprite *other);
+
+/* =========================================================================
+ * Asynchronous Loading
+ * ========================================================================= */
+
+/* Load states reported by arcade_load_status */
+enum
+{
+    ARCADE_LOAD_PENDING = 0, /* Still decoding on a loader thread */
+    ARCADE_LOAD_DONE = 1,    /* Ready; finish it to get the sprite */
+    ARCADE_LOAD_FAILED = 2   /* An image could not be loaded */
+};
+
+/*
+ * ArcadeLoad: Handle of an image or animation being loaded in the background.
+ * Opaque; finish it with arcade_finish_image_load / arcade_finish_animated_load
+ * or drop it with arcade_cancel_load.
+ */
+typedef struct ArcadeLoad ArcadeLoad;
+
+/*
+ * arcade_load_image_sprite_async: Starts loading an image sprite in the background.
+ * Same parameters as arcade_create_image_sprite; returns immediately.
+ * Parameters:
+ * - x, y: Initial position (pixels, float).
+ * - w, h: Desired width and height (pixels, float).
+ * - filename: Path to the image file (e.g., "sprites/player.png").
+ * Returns:
+ * - Load handle, or NULL if the load could not be queued.
+ * Example:
+ *   ArcadeLoad *player_load = arcade_load_image_sprite_async(100.0f, 100.0f, 50.0f, 50.0f, "player.png");
+ * Notes:
+ * - The first call starts one loader thread per CPU core (see arcade_set_loader_threads).
+ * - Images go through the asset cache, so sprites of the same file and size share pixels.
+ */
+ArcadeLoad *arcade_load_image_sprite_async(float x, float y, float w, float h, const char *filename);
+
+/*
+ * arcade_load_animated_sprite_async: Starts loading the frames of an animated sprite in the background.
+ * Same parameters as arcade_create_animated_sprite; frames are decoded in parallel.
+ * Parameters:
+ * - x, y: Initial position (pixels, float).
+ * - w, h: Desired width and height for each frame (pixels, float).
+ * - filenames: Array of image file paths (copied, may be freed after the call).
+ * - frame_count: Number of frames.
+ * - frame_interval: Frames between animation updates.
+ * Returns:
+ * - Load handle, or NULL if the load could not be queued.
+ * Example:
+ *   const char *frames[] = {"bird1.png", "bird2.png", "bird3.png"};
+ *   ArcadeLoad *bird_load = arcade_load_animated_sprite_async(50.0f, 50.0f, 40.0f, 40.0f, frames, 3, 5);
+ */
+ArcadeLoad *arcade_load_animated_sprite_async(float x, float y, float w, float h, const char **filenames, int frame_count, int frame_interval);
+
+/*
+ * arcade_poll_loads: Collects loads that finished since the last call.
+ * Call once per frame; load states only change here.
+ * Parameters: None.
+ * Returns:
+ * - Number of loads still pending.
+ * Example:
+ *   while (arcade_running() && arcade_update() && arcade_poll_loads() > 0) {
+ *       arcade_render_text_centered("Loading...", 300.0f, 0xFFFFFF);
+ *       arcade_sleep(16);
+ *   }
+ */
+int arcade_poll_loads(void);
+
+/*
+ * arcade_load_status: Returns the state of a load as of the last arcade_poll_loads.
+ * Parameters:
+ * - load: Load handle.
+ * Returns:
+ * - ARCADE_LOAD_PENDING, ARCADE_LOAD_DONE or ARCADE_LOAD_FAILED (also for NULL).
+ * Example:
+ *   if (arcade_load_status(player_load) == ARCADE_LOAD_DONE) {
+ *       player = arcade_finish_image_load(player_load);
+ *   }
+ */
+int arcade_load_status(const ArcadeLoad *load);
+
+/*
+ * arcade_finish_image_load: Turns a completed load into an image sprite.
+ * Parameters:
+ * - load: Handle from arcade_load_image_sprite_async.
+ * Returns:
+ * - The loaded sprite, or an empty sprite (pixels = NULL) if the load failed.
+ * Example:
+ *   ArcadeImageSprite player = arcade_finish_image_load(player_load);
+ * Notes:
+ * - Frees the handle unless the load is still pending (then nothing happens
+ *   and an empty sprite is returned).
+ * - Release the sprite like one from arcade_create_image_sprite.
+ */
+ArcadeImageSprite arcade_finish_image_load(ArcadeLoad *load);
+
+/*
+ * arcade_finish_animated_load: Turns a completed load into an animated sprite.
+ * Parameters:
+ * - load: Handle from arcade_load_animated_sprite_async.
+ * Returns:
+ * - The loaded animated sprite, or an empty one (frames = NULL) if any frame failed.
+ * Example:
+ *   ArcadeAnimatedSprite bird = arcade_finish_animated_load(bird_load);
+ * Notes:
+ * - Frees the handle unless the load is still pending.
+ * - Free the result with arcade_free_animated_sprite.
+ */
+ArcadeAnimatedSprite arcade_finish_animated_load(ArcadeLoad *load);
+
+/*
+ * arcade_cancel_load: Drops a load that will not be finished.
+ * Parameters:
+ * - load: Load handle (may be NULL).
+ * Returns: None.
+ * Example:
+ *   arcade_cancel_load(bird_load); // Player left the level early
+ * Notes:
+ * - A pending load keeps decoding and is freed by a later arcade_poll_loads.
+ */
+void arcade_cancel_load(ArcadeLoad *load);
+
+/*
+ * arcade_set_loader_threads: Sets the number of background loader threads.
+ * Parameters:
+ * - threads: Number of threads (0 = stop the loaders).
+ * Returns:
+ * - 0 on success, 1 if the threads could not be started.
+ * Example:
+ *   arcade_set_loader_threads(2); // Leave the other cores to the game
+ * Notes:
+ * - Optional: the first async load starts one thread per CPU core.
+ * - Stopping fails frames that no thread has started yet; arcade_quit stops the loaders.
+ */
+int arcade_set_loader_threads(int threads);
+
+/* =========================================================================
+ * Rendering
+ * ========================================================================= */
+
+/*
+ * arcade_render_scene: Renders a scene with multiple sprites.
+ * Draws all sprites to the pixel buffer and updates the window.
+ * Parameters:
+ * - sprites: Array of ArcadeAnySprite (color or image-based).
+ * - count: Number of sprites to render.
+ * - types: Array of sprite types (SPRITE_COLOR or SPRITE_IMAGE).
+ * Returns: None.
+ * Example:
+ *   ArcadeAnySprite sprites[2] = {{.sprite = platform}, {.image_sprite = player}};
+ *   int types[2] = {SPRITE_COLOR, SPRITE_IMAGE};
+ *   arcade_render_scene(sprites, 2, types);
+ * Notes:
+ * - Clears the screen to the background color before rendering.
+ * - Uses double buffering (Windows: GDI bitmap, Linux: XImage).
+ * - On Linux with MIT-SHM, waits for the previous frame's completion event
+ *   before drawing so the server never reads a half-drawn frame.
+ * - Ignores inactive or null sprites.
+ * - Text queued with arcade_render_text since the last render is drawn on top.
+ */
+void arcade_render_scene(ArcadeAnySprite *sprites, int count, int *types);
+
+/*
+ * arcade_present_mode: Reports which presentation path is active.
+ * Useful for logging or diagnosing frame time on different X servers.
+ * Parameters: None.
+ * Returns:
+ * - ARCADE_PRESENT_XSHM if frames are presented through MIT-SHM.
+ * - ARCADE_PRESENT_BLIT if frames are copied with XPutImage (Linux) or BitBlt (Windows).
+ * - ARCADE_PRESENT_NONE if running headless.
+ * Example:
+ *   arcade_init(800, 600, "My Game", 0x000000);
+ *   if (arcade_present_mode() != ARCADE_PRESENT_XSHM) {
+ *       fprintf(stderr, "MIT-SHM unavailable, using XPutImage\n");
+ *   }
+ * Notes:
+ * - Call after arcade_init; the path is chosen once at initialization.
+ * - Falls back to ARCADE_PRESENT_BLIT automatically when the X server lacks
+ *   MIT-SHM or rejects the segment (e.g., remote displays over SSH).
+ * - Always ARCADE_PRESENT_BLIT when compiled with -DARCADE_NO_XSHM.
+ */
+int arcade_present_mode(void);
+
+/*
+ * arcade_set_dirty_tracking: Enables or disables partial redraws.
+ * When enabled, arcade_render_scene compares each sprite with the one drawn at
+ * the same index last frame and only clears, redraws and presents the regions
+ * that changed (the union of old and new bounds, merged into a few rectangles).
+ * Parameters:
+ * - enabled: 1 to enable, 0 to always redraw the full window (default).
+ * Returns: None.
+ * Example:
+ *   arcade_set_dirty_tracking(1); // Mostly static menu or puzzle screen
+ *   while (arcade_running() && arcade_update()) {
+ *       arcade_render_group(&menu);
+ *       arcade_sleep(16);
+ *   }
+ * Notes:
+ * - Falls back to a full redraw when more than half the window changed.
+ * - Sprites are compared by position, size, color, pixel pointer and active
+ *   state; call arcade_invalidate after editing an image's pixels in place.
+ * - Text drawn with arcade_render_text is tracked: the next frame repaints
+ *   the area under it.
+ * - If nothing changed, nothing is presented.
+ */
+void arcade_set_dirty_tracking(int enabled);
+
+/*
+ * arcade_invalidate: Forces the next arcade_render_scene to redraw everything.
+ * Only relevant when dirty tracking is enabled.
+ * Parameters: None.
+ * Returns: None.
+ * Example:
+ *   arcade_set_dirty_tracking(1);
+ *   ...
+ *   arcade_invalidate(); // Pixels of a loaded image were edited
+ * Notes:
+ * - Window exposure (e.g., uncovering the window) invalidates automatically.
+ */
+void arcade_invalidate(void);
+
+/*
+ * arcade_set_render_threads: Renders scenes on several threads.
+ * Splits the window into 64x64 tiles, sorts each sprite into the tiles it
+ * covers and lets a fixed pool of worker threads draw whole tiles in parallel.
+ * Parameters:
+ * - threads: Total number of rendering threads, including the calling thread
+ *   (0 or 1 = render on the calling thread only, the default).
+ * Returns:
+ * - 0 on success, 1 if the worker threads could not be started (rendering
+ *   stays single-threaded).
+ * Example:
+ *   arcade_set_render_threads(4); // Bullet-hell scene with thousands of sprites
+ * Notes:
+ * - Output is identical to single-threaded rendering; sprites are still drawn
+ *   in array order.
+ * - Pays off for sprite-heavy scenes; small scenes render faster on one thread.
+ * - Works together with dirty tracking: only changed regions are redrawn.
+ * - Calling it again replaces the pool; arcade_quit stops the workers.
+ */
+int arcade_set_render_threads(int threads);
+
+/*
+ * arcade_render_text: Renders text at a specified position.
+ * Draws text into the pixel buffer with the built-in 8x16 bitmap font.
+ * Parameters:
+ * - text: Null-terminated string to render.
+ * - x, y: Position of the text’s top-left corner (pixels, float).
+ * - color: Text color (0xRRGGBB, e.g., 0xFFFFFF for white).
+ * Returns: None.
+ * Example:
+ *   arcade_render_text("Score: 10", 10.0f, 10.0f, 0xFFFFFF);
+ *   arcade_render_group(&group); // Draws the sprites, then the text, and shows both
+ * Notes:
+ * - y is the top of the text. Under X11, y used to be the baseline of the text, so
+ *   existing code draws its text about one line (16 pixels) lower than before.
+ * - The text is queued and drawn over the sprites by the next arcade_render_scene or
+ *   arcade_render_group, which presents the frame and its text together. Call this
+ *   before rendering the frame; text queued after it shows in the following frame.
+ * - Text lasts one frame: call this again every frame to keep it on screen.
+ * - In a loop that renders no scene (e.g. a pause or game over screen), arcade_update
+ *   draws and shows the queued text over the last frame instead.
+ * - Text is rendered with a transparent background, 8 pixels per character
+ *   and 16 pixels tall; characters outside printable ASCII are drawn as '?'.
+ * - Recently drawn strings are cached, so redrawing a static HUD string
+ *   each frame only copies its pixel runs.
+ * - Skips rendering if text is null.
+ */
+void arcade_render_text(const char *text, float x, float y, unsigned int color);
+
+/*
+ * arcade_render_text_centered: Renders text centered horizontally.
+ * Calculates the x-position to center the text based on its width.
+ * Parameters:
+ * - text: Null-terminated string to render.
+ * - y: Vertical position of the text’s top edge (pixels, float).
+ * - color: Text color (0xRRGGBB).
+ * Returns: None.
+ * Example:
+ *   arcade_render_text_centered("Game Over", 300.0f, 0xFF0000);
+ * Notes:
+ * - Uses the same font as arcade_render_text, and is likewise drawn by the next scene render.
+ * - Skips rendering if text is null.
+ */
+void arcade_render_text_centered(const char *text, float y, unsigned int color);
+
+/*
+ * arcade_render_text_centered_blink: Renders centered text that blinks.
+ * Toggles visibility based on a frame interval.
  * Parameters:
  * - text: Null-terminated string to render.
  * - y: Vertical position of the text’s top edge (pixels, float).
@@ -825,6 +1726,21 @@ void arcade_add_sprite_to_group(SpriteGroup *group, ArcadeAnySprite sprite, int
  */
 void arcade_add_animated_to_group(SpriteGroup *group, ArcadeAnimatedSprite *anim);
 
+/*
+ * arcade_add_anim_instance_to_group: Adds an animation instance's current frame to a group.
+ * Parameters:
+ * - group: Pointer to SpriteGroup.
+ * - instance: Animation instance.
+ * Returns: None.
+ * Example:
+ *   for (int i = 0; i < 1000; i++)
+ *       arcade_add_anim_instance_to_group(&group, &enemies[i]);
+ * Notes:
+ * - Same as arcade_add_animated_to_group (type = SPRITE_IMAGE, call each frame).
+ * - Ignores inactive or null instances.
+ */
+void arcade_add_anim_instance_to_group(SpriteGroup *group, const ArcadeAnimInstance *instance);
+
 /*
  * arcade_render_group: Renders all sprites in a sprite group.
  * Calls arcade_render_scene with the group’s sprites and types.
@@ -836,6 +1752,7 @@ void arcade_add_animated_to_group(SpriteGroup *group, ArcadeAnimatedSprite *anim
  * Notes:
  * - Clears the screen and renders all active sprites.
  * - More efficient than rendering sprites individually.
+ * - Draws queued text on top, like arcade_render_scene.
  */
 void arcade_render_group(SpriteGroup *group);
 
@@ -853,13 +1770,361 @@ void arcade_render_group(SpriteGroup *group);
  */
 void arcade_free_group(SpriteGroup *group);
 
+/* =========================================================================
+ * Collision Broadphase
+ * ========================================================================= */
+
+/*
+ * ArcadeSpatialHash: Grid of sprite boxes for finding collisions without
+ * testing every pair. Opaque; create with arcade_create_spatial_hash and free
+ * with arcade_free_spatial_hash.
+ */
+typedef struct ArcadeSpatialHash ArcadeSpatialHash;
+
+/*
+ * ArcadeCollisionPair: Two overlapping sprites, as indices into the group the hash was built from.
+ * Fields:
+ * - a, b: Sprite indices, a < b.
+ */
+typedef struct
+{
+    int a, b; /* Indices of the two sprites (a < b) */
+} ArcadeCollisionPair;
+
+/*
+ * arcade_create_spatial_hash: Creates an empty spatial hash.
+ * Parameters:
+ * - cell_size: Grid cell size in pixels, or 0 to pick one from the sprites on every build.
+ * Returns:
+ * - Pointer to the hash, or NULL on failure.
+ * Example:
+ *   ArcadeSpatialHash *hash = arcade_create_spatial_hash(0.0f);
+ * Notes:
+ * - Cells about the size of a typical sprite work best; 0 uses twice the average sprite size.
+ */
+ArcadeSpatialHash *arcade_create_spatial_hash(float cell_size);
+
+/*
+ * arcade_spatial_hash_build: Fills the hash with the sprites of a group.
+ * Call once per frame after moving sprites; the previous contents are replaced.
+ * Parameters:
+ * - hash: Hash to fill.
+ * - group: Sprites to index; results refer to their positions in group->sprites.
+ * Returns:
+ * - 0 on success, 1 on failure.
+ * Example:
+ *   arcade_spatial_hash_build(hash, &enemies);
+ * Notes:
+ * - Uses the same boxes as arcade_check_collision / arcade_check_image_collision;
+ *   affine sprites use the box they are drawn in. Inactive sprites are skipped.
+ * - Runs in time proportional to the number of sprites; memory is reused between builds.
+ */
+int arcade_spatial_hash_build(ArcadeSpatialHash *hash, const SpriteGroup *group);
+
+/*
+ * arcade_spatial_hash_pairs: Finds every pair of overlapping sprites in the hash.
+ * Parameters:
+ * - hash: Hash built with arcade_spatial_hash_build.
+ * - pairs: Receives the pairs (owned by the hash, valid until the next build or pairs call).
+ * Returns:
+ * - Number of pairs, or -1 on failure.
+ * Example:
+ *   const ArcadeCollisionPair *hits;
+ *   int n = arcade_spatial_hash_pairs(hash, &hits);
+ *   for (int i = 0; i < n; i++)
+ *       handle_hit(&group.sprites[hits[i].a], &group.sprites[hits[i].b]);
+ * Notes:
+ * - Each pair is reported once; no order is guaranteed between pairs.
+ */
+int arcade_spatial_hash_pairs(ArcadeSpatialHash *hash, const ArcadeCollisionPair **pairs);
+
+/*
+ * arcade_spatial_hash_query: Finds the sprites overlapping a rectangle.
+ * Parameters:
+ * - hash: Hash built with arcade_spatial_hash_build.
+ * - x, y, width, height: Rectangle to test (pixels, float).
+ * - results: Receives sprite indices (owned by the hash, valid until the next build or query).
+ * Returns:
+ * - Number of sprites found, or -1 on failure.
+ * Example:
+ *   // Bullets against enemies: index the enemies once, then query per bullet
+ *   arcade_spatial_hash_build(hash, &enemies);
+ *   for (int i = 0; i < bullet_count; i++) {
+ *       const int *hit;
+ *       int n = arcade_spatial_hash_query(hash, bullets[i].x, bullets[i].y, bullets[i].width, bullets[i].height, &hit);
+ *       ...
+ *   }
+ * Notes:
+ * - Each sprite is reported once; touching edges do not count as overlapping.
+ */
+int arcade_spatial_hash_query(ArcadeSpatialHash *hash, float x, float y, float width, float height, const int **results);
+
+/*
+ * arcade_free_spatial_hash: Frees a spatial hash.
+ * Parameters:
+ * - hash: Hash to free (NULL is ignored).
+ * Returns: None.
+ * Example:
+ *   arcade_free_spatial_hash(hash);
+ */
+void arcade_free_spatial_hash(ArcadeSpatialHash *hash);
+
+/*
+ * ArcadeBoxes: Collision boxes stored structure-of-arrays for batch tests.
+ * Fields:
+ * - x, y: Top-left corners (count entries each).
+ * - width, height: Box sizes (count entries each).
+ * - count: Number of boxes in use.
+ * - capacity: Number of boxes allocated.
+ * Example:
+ *   ArcadeBoxes bullets;
+ *   arcade_init_boxes(&bullets, 2000);
+ *   arcade_boxes_from_group(&bullets, &bullet_group);
+ * Notes:
+ * - Fill the arrays directly or with arcade_boxes_from_group; keep count <= capacity.
+ * - A box whose x is NaN never collides.
+ * - Free with arcade_free_boxes.
+ */
+typedef struct
+{
+    float *x, *y;          /* Top-left corners */
+    float *width, *height; /* Sizes */
+    int count;             /* Boxes in use */
+    int capacity;          /* Boxes allocated */
+} ArcadeBoxes;
+
+/*
+ * arcade_init_boxes: Allocates box arrays.
+ * Parameters:
+ * - boxes: Pointer to ArcadeBoxes to initialize.
+ * - capacity: Number of boxes to allocate (rounded up to a multiple of 16).
+ * Returns:
+ * - 0 on success, 1 on failure.
+ * Example:
+ *   ArcadeBoxes boxes;
+ *   if (arcade_init_boxes(&boxes, 256) != 0) { ... }
+ */
+int arcade_init_boxes(ArcadeBoxes *boxes, int capacity);
+
+/*
+ * arcade_boxes_from_group: Copies the collision boxes of a group's sprites.
+ * Parameters:
+ * - boxes: Initialized ArcadeBoxes; grown if the group is larger than its capacity.
+ * - group: Sprites to copy; box i belongs to group->sprites[i].
+ * Returns:
+ * - 0 on success, 1 on failure.
+ * Example:
+ *   arcade_boxes_from_group(&boxes, &enemies);
+ * Notes:
+ * - Boxes match arcade_check_collision / arcade_check_image_collision; affine sprites
+ *   use the box they are drawn in, and inactive sprites get boxes that never hit.
+ */
+int arcade_boxes_from_group(ArcadeBoxes *boxes, const SpriteGroup *group);
+
+/*
+ * arcade_collide_boxes: Tests one box against every box in an ArcadeBoxes.
+ * Parameters:
+ * - boxes: Boxes to test.
+ * - x, y, width, height: The box to test them against (pixels, float).
+ * - hits: Receives a bitmask, (boxes->count + 31) / 32 words; bit i % 32 of
+ *   word i / 32 is set if box i overlaps.
+ * Returns:
+ * - Number of overlapping boxes.
+ * Example:
+ *   uint32_t hits[(2000 + 31) / 32];
+ *   if (arcade_collide_boxes(&bullets, player.x, player.y, player.width, player.height, hits) > 0)
+ *       for (int i = 0; i < bullets.count; i++)
+ *           if (hits[i / 32] & (1u << (i % 32)))
+ *               hit_player(i);
+ * Notes:
+ * - Same overlap rule as arcade_check_collision (touching edges do not count).
+ * - Tests 8 boxes per step with AVX2 (4 with SSE2). To test a set of boxes,
+ *   call once per box.
+ */
+int arcade_collide_boxes(const ArcadeBoxes *boxes, float x, float y, float width, float height, uint32_t *hits);
+
+/*
+ * arcade_free_boxes: Frees box arrays.
+ * Parameters:
+ * - boxes: Pointer to ArcadeBoxes to free.
+ * Returns: None.
+ * Example:
+ *   arcade_free_boxes(&boxes);
+ */
+void arcade_free_boxes(ArcadeBoxes *boxes);
+
+/*
+ * ArcadeSweepHit: First contact of a box moving along a straight line.
+ * Fields:
+ * - time: Fraction of the move done at contact (0 to 1); move by time * (dx, dy) to stop touching.
+ * - normal_x, normal_y: Outward normal of the face that was hit: (-1, 0), (1, 0), (0, -1) or (0, 1);
+ *   (0, 0) when the boxes already overlapped at the start.
+ * - index: Sprite index for arcade_sweep_group, -1 for arcade_sweep_box.
+ */
+typedef struct
+{
+    float time;               /* Fraction of the move before contact (0 to 1) */
+    float normal_x, normal_y; /* Normal of the face hit (0, 0 if overlapping at the start) */
+    int index;                /* Sprite hit, or -1 */
+} ArcadeSweepHit;
+
+/*
+ * arcade_sweep_box: Finds when a moving box first touches a still one.
+ * Parameters:
+ * - x, y, width, height: Moving box at the start of the step (pixels, float).
+ * - dx, dy: Movement over the step (pixels, float), e.g. the sprite's vx and vy.
+ * - box_x, box_y, box_width, box_height: Still box (pixels, float).
+ * - hit: Receives the contact.
+ * Returns:
+ * - 1 if the boxes overlap at some point of the move, 0 if not.
+ * Example:
+ *   ArcadeSweepHit hit;
+ *   if (arcade_sweep_box(bullet.x, bullet.y, bullet.width, bullet.height, bullet.vx, bullet.vy,
+ *                        wall.x, wall.y, wall.width, wall.height, &hit)) {
+ *       bullet.x += bullet.vx * hit.time;
+ *       bullet.y += bullet.vy * hit.time;
+ *       bullet.active = 0;
+ *   }
+ * Notes:
+ * - Catches boxes passed through entirely within the step, however fast the move.
+ * - Touching edges do not count, as in arcade_check_collision, so a box can slide along
+ *   a wall it rests against; moving into that wall reports time 0.
+ */
+int arcade_sweep_box(float x, float y, float width, float height, float dx, float dy, float box_x, float box_y,
+                     float box_width, float box_height, ArcadeSweepHit *hit);
+
+/*
+ * arcade_sweep_group: Finds the first sprite of a group a moving box would touch.
+ * Parameters:
+ * - x, y, width, height: Moving box at the start of the step (pixels, float).
+ * - dx, dy: Movement over the step (pixels, float).
+ * - group: Sprites to test, with the same boxes as arcade_spatial_hash_build.
+ * - indices: Sprite indices to test (e.g. from arcade_spatial_hash_query), or NULL for all.
+ * - count: Number of indices (ignored when indices is NULL).
+ * - hit: Receives the earliest contact; hit->index is the sprite.
+ * Returns:
+ * - 1 if any sprite is touched during the move, 0 if not.
+ * Example:
+ *   // Query the area the bullet sweeps, then keep the earliest contact
+ *   float x0 = fminf(b->x, b->x + b->vx), y0 = fminf(b->y, b->y + b->vy);
+ *   const int *near;
+ *   int n = arcade_spatial_hash_query(hash, x0, y0, b->width + fabsf(b->vx), b->height + fabsf(b->vy), &near);
+ *   ArcadeSweepHit hit;
+ *   if (n > 0 && arcade_sweep_group(b->x, b->y, b->width, b->height, b->vx, b->vy, &walls, near, n, &hit))
+ *       handle_hit(b, &walls.sprites[hit.index], &hit);
+ * Notes:
+ * - Inactive sprites and out-of-range indices are skipped.
+ * - When several sprites are touched at the same time, the first one listed is reported.
+ */
+int arcade_sweep_group(float x, float y, float width, float height, float dx, float dy, const SpriteGroup *group,
+                       const int *indices, int count, ArcadeSweepHit *hit);
+
 /* =========================================================================
  * Audio
  * ========================================================================= */
 
+/* Audio sinks for arcade_audio_open */
+enum
+{
+    ARCADE_AUDIO_AUTO = 0,   /* Sound device, or null when headless or no device is available */
+    ARCADE_AUDIO_DEVICE = 1, /* Sound device only (ALSA on Linux, waveOut on Windows) */
+    ARCADE_AUDIO_NULL = 2,   /* Mix and discard (silent, keeps real-time pacing) */
+    ARCADE_AUDIO_WAV = 3     /* Write the mixed output to a WAV file */
+};
+
+/*
+ * ArcadeSound: A decoded sound, ready to be mixed.
+ * Opaque; create with arcade_load_sound and release with arcade_free_sound.
+ */
+typedef struct ArcadeSound ArcadeSound;
+
+/*
+ * arcade_audio_open: Starts the audio mixer on a chosen output.
+ * The mixer runs on its own thread and plays up to 32 sounds at once.
+ * Parameters:
+ * - sink: ARCADE_AUDIO_AUTO, ARCADE_AUDIO_DEVICE, ARCADE_AUDIO_NULL or ARCADE_AUDIO_WAV.
+ * - wav_path: Output file for ARCADE_AUDIO_WAV (ignored otherwise).
+ * Returns:
+ * - 0 on success, 1 if the sink cannot be opened.
+ * Example:
+ *   arcade_audio_open(ARCADE_AUDIO_WAV, "/tmp/game_audio.wav"); // Record a test run
+ * Notes:
+ * - Optional: the first arcade_play_sound opens ARCADE_AUDIO_AUTO.
+ * - ARCADE_AUDIO_AUTO uses the null sink when ARCADE_HEADLESS is set.
+ * - Linux: ALSA (libasound.so.2) is loaded at run time; no build dependency.
+ * - Reopening stops all sounds and closes the previous sink.
+ */
+int arcade_audio_open(int sink, const char *wav_path);
+
+/*
+ * arcade_audio_close: Stops the mixer and closes the audio sink.
+ * Parameters: None.
+ * Returns: None.
+ * Example:
+ *   arcade_audio_close();
+ * Notes:
+ * - Called by arcade_quit. Required before exit to finish a WAV sink's file.
+ * - Sounds from arcade_load_sound stay valid; the arcade_play_sound cache is freed.
+ */
+void arcade_audio_close(void);
+
+/*
+ * arcade_load_sound: Loads and decodes a WAV file for repeated playback.
+ * Parameters:
+ * - audio_file_path: Path to the WAV file (e.g., "audio/shot.wav").
+ * Returns:
+ * - Decoded sound, or NULL on failure (file missing or unsupported format).
+ * Example:
+ *   ArcadeSound *shot = arcade_load_sound("audio/shot.wav");
+ *   if (arcade_key_pressed(a_space)) {
+ *       arcade_play_loaded_sound(shot, 0.5f, 0);
+ *   }
+ * Notes:
+ * - Accepts 8- or 16-bit PCM WAV, any channel count and sample rate; the
+ *   data is converted once to 44.1 kHz stereo.
+ * - Free with arcade_free_sound.
+ */
+ArcadeSound *arcade_load_sound(const char *audio_file_path);
+
+/*
+ * arcade_free_sound: Releases a sound from arcade_load_sound.
+ * Parameters:
+ * - sound: Sound to release (NULL is ignored).
+ * Returns: None.
+ * Notes:
+ * - Safe while the sound is playing; the memory is freed when playback ends.
+ */
+void arcade_free_sound(ArcadeSound *sound);
+
+/*
+ * arcade_play_loaded_sound: Plays a decoded sound.
+ * Parameters:
+ * - sound: Sound from arcade_load_sound.
+ * - volume: Voice volume (1.0 = original, 0.0 to 4.0).
+ * - loop: 1 to repeat until arcade_stop_sound, 0 to play once.
+ * Returns:
+ * - 0 on success, 1 on failure (no sound, audio unavailable or too many queued commands).
+ * Example:
+ *   arcade_play_loaded_sound(music, 0.6f, 1); // Background loop
+ * Notes:
+ * - Returns immediately; the mixer starts the sound within one period (~12 ms).
+ * - When all voices are busy, the one that has played longest is replaced.
+ */
+int arcade_play_loaded_sound(ArcadeSound *sound, float volume, int loop);
+
+/*
+ * arcade_set_master_volume: Scales the mixed output.
+ * Parameters:
+ * - volume: Master volume (1.0 = unchanged, 0.0 to 4.0).
+ * Returns: None.
+ * Example:
+ *   arcade_set_master_volume(0.0f); // Mute
+ */
+void arcade_set_master_volume(float volume);
+
 /*
  * arcade_play_sound: Plays a WAV audio file.
- * Plays the file asynchronously (non-blocking).
+ * Plays the file asynchronously (non-blocking) through the in-process mixer.
  * Parameters:
  * - audio_file_path: Path to the WAV file (e.g., "audio/sfx.wav").
  * Returns:
@@ -870,20 +2135,20 @@ void arcade_free_group(SpriteGroup *group);
  *       arcade_play_sound("audio/jump.wav");
  *   }
  * Notes:
- * - Windows: Uses PlaySound with SND_FILENAME | SND_ASYNC.
- * - Linux: Uses aplay (requires alsa-utils).
- * - WAV files must be PCM, 16-bit, mono/stereo.
- * - Frequent calls may cause delays on slow systems; consider preloading for Windows.
+ * - Each file is decoded on its first use and cached until arcade_audio_close,
+ *   so repeated effects cost no file or process work.
+ * - Overlapping calls mix together instead of interrupting each other.
+ * - WAV files must be 8- or 16-bit PCM (see arcade_load_sound).
  */
 int arcade_play_sound(const char *audio_file_path);
 
 /*
- * arcade_stop_sound: Stops any currently playing WAV audio.
- * Immediately halts sound playback started by arcade_play_sound.
+ * arcade_stop_sound: Stops all playing sounds.
+ * Immediately halts sounds started by arcade_play_sound and arcade_play_loaded_sound.
  *
  * Returns:
  * - 0 on success.
- * - Non-zero on failure (e.g., no sound playing or command fails).
+ * - Non-zero if the stop request could not be queued.
  *
  * Example:
  *   if (arcade_key_pressed_once(a_s)) {
@@ -891,11 +2156,8 @@ int arcade_play_sound(const char *audio_file_path);
  *   }
  *
  * Notes:
- * - Windows: Uses PlaySound(NULL, NULL, 0) to stop current async playback.
- * - Linux: Uses pkill to terminate background `aplay` processes.
- *   This assumes that only arcade_play_sound uses `aplay -q`.
- * - This function stops all active sounds immediately. It does not pause.
- * - If multiple arcade_play_sound calls were triggered quickly, this will halt them all.
+ * - This function stops all active sounds, including loops. It does not pause.
+ * - The mixer keeps running; later plays start normally.
  */
 int arcade_stop_sound(void);
 
@@ -903,6 +2165,76 @@ int arcade_stop_sound(void);
  * Image Manipulation
  * ========================================================================= */
 
+/* Flip directions for arcade_flip_pixels and arcade_flip_sprite */
+enum
+{
+    ARCADE_FLIP_HORIZONTAL = 0, /* Mirror left to right */
+    ARCADE_FLIP_VERTICAL = 1    /* Mirror top to bottom */
+};
+
+/*
+ * arcade_flip_sprite: Returns a flipped copy of an image sprite.
+ * Works on the sprite's decoded pixels; no file is read or written.
+ * Parameters:
+ * - sprite: Sprite to flip (unchanged).
+ * - flip_type: ARCADE_FLIP_HORIZONTAL or ARCADE_FLIP_VERTICAL.
+ * Returns:
+ * - New sprite at the same position with flipped pixels, or a zeroed sprite on failure.
+ * Example:
+ *   ArcadeImageSprite left = arcade_flip_sprite(&player, ARCADE_FLIP_HORIZONTAL);
+ *   ...
+ *   arcade_free_image_sprite(&left);
+ * Notes:
+ * - The copy owns its pixels; free it with arcade_free_image_sprite.
+ * - Counted in arcade_asset_stats like any other image.
+ */
+ArcadeImageSprite arcade_flip_sprite(const ArcadeImageSprite *sprite, int flip_type);
+
+/*
+ * arcade_rotate_sprite: Returns a copy of an image sprite rotated clockwise.
+ * Parameters:
+ * - sprite: Sprite to rotate (unchanged).
+ * - degrees: Multiple of 90 (negative values rotate counter-clockwise).
+ * Returns:
+ * - New sprite at the same position with rotated pixels, or a zeroed sprite on failure.
+ * Example:
+ *   ArcadeImageSprite up = arcade_rotate_sprite(&ship, 270);
+ * Notes:
+ * - Rotations of 90/270 swap width and height.
+ * - Free the copy with arcade_free_image_sprite.
+ */
+ArcadeImageSprite arcade_rotate_sprite(const ArcadeImageSprite *sprite, int degrees);
+
+/*
+ * arcade_flip_pixels: Flips a 32-bit pixel buffer in place.
+ * Parameters:
+ * - pixels: First pixel of the buffer.
+ * - width, height: Size in pixels.
+ * - stride: Pixels per row (0 for width).
+ * - flip_type: ARCADE_FLIP_HORIZONTAL or ARCADE_FLIP_VERTICAL.
+ * Example:
+ *   arcade_flip_pixels(buffer, 64, 64, 0, ARCADE_FLIP_VERTICAL);
+ * Notes:
+ * - Any 4-byte pixel format works; channels are not touched.
+ */
+void arcade_flip_pixels(uint32_t *pixels, int width, int height, int stride, int flip_type);
+
+/*
+ * arcade_rotate_pixels: Rotates a 32-bit pixel buffer clockwise into another buffer.
+ * Parameters:
+ * - dst: Output buffer, tightly packed (height x width pixels for 90/270).
+ * - src: Input buffer; must not overlap dst.
+ * - width, height: Size of src in pixels.
+ * - src_stride: Pixels per src row (0 for width).
+ * - degrees: Multiple of 90 (negative values rotate counter-clockwise).
+ * Returns:
+ * - 0 on success, 1 for invalid arguments or angles.
+ * Example:
+ *   uint32_t *out = malloc(w * h * sizeof(uint32_t));
+ *   arcade_rotate_pixels(out, in, w, h, 0, 90); // out is h pixels wide
+ */
+int arcade_rotate_pixels(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int degrees);
+
 /*
  * arcade_flip_image: Flips an image vertically or horizontally.
  * Creates a new image file with the flipped content.
@@ -922,6 +2254,7 @@ int arcade_stop_sound(void);
  * - Creates a temporary PNG file (Windows: current directory, Linux: /tmp).
  * - Caller must free the returned path.
  * - Ensure write permissions in the output directory.
+ * - Prefer arcade_flip_sprite for sprites that are already loaded.
  */
 char *arcade_flip_image(const char *input_path, int flip_type);
 
@@ -944,7 +2277,95 @@ char *arcade_flip_image(const char *input_path, int flip_type);
  * - Creates a temporary PNG file (Windows: current directory, Linux: /tmp).
  * - Caller must free the returned path.
  * - Rotations of 90/270 swap width and height.
+ * - Prefer arcade_rotate_sprite for sprites that are already loaded.
  */
 char *arcade_rotate_image(const char *input_path, int degrees);
 
+/* =========================================================================
+ * Contexts
+ * ========================================================================= */
+
+/*
+ * arcade_context_create: Allocates a new, uninitialized arcade context.
+ * Parameters: None.
+ * Returns:
+ * - Pointer to the new context, or NULL if allocation fails.
+ * Example:
+ *   ArcadeContext *ctx = arcade_context_create();
+ *   if (!ctx || arcade_ctx_init_headless(ctx, 640, 480, 0x000000)) {
+ *       return 1;
+ *   }
+ * Notes:
+ * - Initialize with arcade_ctx_init or arcade_ctx_init_headless before use.
+ * - Release with arcade_context_destroy.
+ */
+ArcadeContext *arcade_context_create(void);
+
+/*
+ * arcade_context_destroy: Shuts down and frees a context.
+ * Calls arcade_ctx_quit and releases the context itself.
+ * Parameters:
+ * - ctx: Context from arcade_context_create.
+ * Returns: None.
+ * Example:
+ *   arcade_context_destroy(ctx);
+ * Notes:
+ * - Safe to call with NULL.
+ * - Ignored for the default context (use arcade_quit instead).
+ */
+void arcade_context_destroy(ArcadeContext *ctx);
+
+/*
+ * arcade_default_context: Returns the context used by the functions without a ctx parameter.
+ * Parameters: None.
+ * Returns: Pointer to the default context (never NULL).
+ * Example:
+ *   arcade_init(800, 600, "My Game", 0x000000);
+ *   ArcadeContext *ctx = arcade_default_context();
+ *   arcade_ctx_render_group(ctx, &group); // Same as arcade_render_group(&group)
+ * Notes:
+ * - Lets code written against the ctx API drive a game started with arcade_init.
+ */
+ArcadeContext *arcade_default_context(void);
+
+/*
+ * Context variants of the core, input and rendering functions.
+ * Each behaves exactly like the function of the same name without "ctx_",
+ * but operates on the given context instead of the default one.
+ * Example:
+ *   ArcadeContext *sims[4];
+ *   for (int i = 0; i < 4; i++) {
+ *       sims[i] = arcade_context_create();
+ *       arcade_ctx_init_headless(sims[i], 320, 240, 0x000000);
+ *   }
+ *   // Each sims[i] can now be stepped from its own thread.
+ * Notes:
+ * - A context must only be used by one thread at a time.
+ * - Headless contexts are fully independent. Windowed contexts on separate
+ *   threads also require XInitThreads (Linux) before the first arcade call.
+ * - On Windows, a windowed context must be updated from the thread that
+ *   initialized it (Win32 message queues are per thread).
+ */
+int arcade_ctx_init(ArcadeContext *ctx, int window_width, int window_height, const char *window_title, uint32_t bg_color);
+int arcade_ctx_init_headless(ArcadeContext *ctx, int width, int height, uint32_t bg_color);
+void arcade_ctx_quit(ArcadeContext *ctx);
+int arcade_ctx_update(ArcadeContext *ctx);
+int arcade_ctx_running(ArcadeContext *ctx);
+void arcade_ctx_set_running(ArcadeContext *ctx, int value);
+int arcade_ctx_frame_count(ArcadeContext *ctx);
+float arcade_ctx_delta_time(ArcadeContext *ctx);
+int arcade_ctx_key_pressed(ArcadeContext *ctx, unsigned int key_val);
+int arcade_ctx_key_pressed_once(ArcadeContext *ctx, unsigned int key_val);
+void arcade_ctx_clear_keys(ArcadeContext *ctx);
+int arcade_ctx_inject_key(ArcadeContext *ctx, unsigned int key_val, int pressed, int frame);
+void arcade_ctx_render_scene(ArcadeContext *ctx, ArcadeAnySprite *sprites, int count, int *types);
+void arcade_ctx_render_group(ArcadeContext *ctx, SpriteGroup *group);
+int arcade_ctx_present_mode(ArcadeContext *ctx);
+void arcade_ctx_set_dirty_tracking(ArcadeContext *ctx, int enabled);
+void arcade_ctx_invalidate(ArcadeContext *ctx);
+int arcade_ctx_set_render_threads(ArcadeContext *ctx, int threads);
+void arcade_ctx_render_text(ArcadeContext *ctx, const char *text, float x, float y, unsigned int color);
+void arcade_ctx_render_text_centered(ArcadeContext *ctx, const char *text, float y, unsigned int color);
+void arcade_ctx_render_text_centered_blink(ArcadeContext *ctx, const char *text, float y, unsigned int color, int blink_interval);
+
 #endif
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <limits.h>
+#include <math.h>
 #include <sys/time.h>
 
 #ifdef _WIN32
@@ -14,6 +16,16 @@
 #include <X11/keysym.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifndef ARCADE_NO_XSHM
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
 #endif
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -35,8 +47,8 @@ typedef struct
     uint32_t *pixels;  /* Pixel buffer for storing rendered frame data */
     int width, height; /* Window dimensions in pixels */
     uint32_t bg_color; /* Background color (0xRRGGBB) for clearing the screen */
-    HFONT hfont;       /* Font handle for text rendering (Courier New) */
     int running;       /* Game running state (1 = running, 0 = stopped) */
+    int headless;      /* 1 if running without a window (pixel buffer only) */
 } ArcadeState;
 #else
 typedef struct
@@ -50,15 +62,100 @@ typedef struct
     XImage *image;     /* X11 image for rendering pixel data to the window */
     GC gc;             /* Graphics context for drawing operations */
     uint32_t bg_color; /* Background color (0xRRGGBB) for clearing the screen */
-    XFontStruct *font; /* Font structure for text rendering (9x15 font) */
     int running;       /* Game running state (1 = running, 0 = stopped) */
+    int headless;      /* 1 if running without a display connection (pixel buffer only) */
+    int present_mode;  /* Active presentation path (ARCADE_PRESENT_BLIT or ARCADE_PRESENT_XSHM) */
+#ifndef ARCADE_NO_XSHM
+    XShmSegmentInfo shm_info; /* Shared memory segment backing the pixel buffer (MIT-SHM path) */
+    int shm_completion;       /* Event type of ShmCompletion events on this display */
+    int shm_pending;          /* Completion events still expected; nonzero while the server may read the pixels */
+#endif
 } ArcadeState;
 #endif
 
-static ArcadeState state = {0};        /* Global state for the arcade environment */
-static int key_states[256] = {0};      /* Current key states (0 = up, 1 = down) for input tracking */
-static int last_key_states[256] = {0}; /* Previous key states for detecting single-press events */
-static int global_frame_counter = 0;   /* Global frame counter for animations and blinking effects */
+typedef struct
+{
+    unsigned int key_val; /* Arcade key code (e.g., a_space) */
+    int pressed;          /* 1 = key down, 0 = key up */
+    int frame;            /* Frame counter value at which the event is applied */
+} ArcadeInputEvent;
+
+#define ARCADE_MAX_DIRTY_RECTS 16    /* Dirty rectangles tracked per frame before merging */
+#define ARCADE_TILE_SIZE 64          /* Edge length of the screen tiles used by the threaded renderer */
+#define ARCADE_MAX_RENDER_THREADS 64 /* Upper bound for arcade_set_render_threads */
+#define ARCADE_MAX_LOADER_THREADS 16 /* Upper bound for arcade_set_loader_threads */
+
+typedef struct
+{
+    int x0, y0; /* Top-left corner (inclusive, pixels) */
+    int x1, y1; /* Bottom-right corner (exclusive, pixels) */
+} ArcadeRegion;
+
+#define ARCADE_TEXT_CACHE_SIZE 32 /* String layouts kept per context */
+#define ARCADE_GLYPH_WIDTH 8      /* Character cell width (pixels) */
+#define ARCADE_GLYPH_HEIGHT 16    /* Character cell height (pixels); 8x8 glyphs drawn with doubled rows */
+
+typedef struct
+{
+    int x, y;   /* Start of the run relative to the string origin (x in pixels, y in glyph rows) */
+    int length; /* Number of lit pixels */
+} ArcadeTextRun;
+
+typedef struct
+{
+    char *text;          /* Laid out string (owned), or NULL for an empty slot */
+    uint32_t hash;       /* Hash of text for quick lookup */
+    int width;           /* Width of the string (pixels) */
+    ArcadeTextRun *runs; /* Horizontal runs of lit pixels covering all glyphs */
+    int run_count;       /* Number of entries in runs */
+    unsigned int used;   /* Value of text_clock at the last lookup, for eviction */
+} ArcadeTextLayout;
+
+typedef struct
+{
+    size_t text;    /* Offset of the string in the queue's chars */
+    int x, y;       /* Top-left corner (pixels) */
+    int width;      /* Width of the string (pixels) */
+    uint32_t color; /* Text color */
+} ArcadeTextItem;
+
+typedef struct
+{
+    ArcadeTextItem *items; /* Strings in the order they were drawn */
+    int count;             /* Number of entries in items */
+    int capacity;          /* Allocated size of items */
+    char *chars;           /* The strings, back to back with their terminators */
+    size_t used;           /* Bytes of chars in use */
+    size_t size;           /* Allocated size of chars */
+} ArcadeTextQueue;
+
+struct ArcadeContext
+{
+    ArcadeState state;             /* Window, pixel buffer and presentation state */
+    int key_states[256];           /* Current key states (0 = up, 1 = down) for input tracking */
+    int last_key_states[256];      /* Previous key states for detecting single-press events */
+    int frame_counter;             /* Frame counter for animations and blinking effects */
+    double last_time;              /* Time of the last arcade_delta_time call (seconds) */
+    ArcadeInputEvent *input_queue; /* Injected key events waiting to be applied by arcade_update */
+    int input_count;               /* Number of queued events */
+    int input_capacity;            /* Allocated size of input_queue */
+    int dirty_tracking;            /* 1 = repaint and present only changed regions */
+    int full_redraw;               /* 1 = next frame repaints the whole window */
+    ArcadeAnySprite *prev_sprites; /* Sprites drawn last frame, for change detection */
+    int *prev_types;               /* Types of prev_sprites */
+    int prev_count;                /* Number of sprites drawn last frame */
+    int prev_capacity;             /* Allocated size of prev_sprites and prev_types */
+    ArcadeRegion dirty[ARCADE_MAX_DIRTY_RECTS]; /* Regions to repaint this frame */
+    int dirty_count;                            /* Number of entries in dirty */
+    struct ArcadeRenderPool *render_pool;       /* Tile renderer workers, or NULL to render serially */
+    ArcadeTextLayout text_cache[ARCADE_TEXT_CACHE_SIZE]; /* Recently drawn strings, ready to blit */
+    unsigned int text_clock;                             /* Incremented on every text cache lookup */
+    ArcadeTextQueue text_queue;                          /* Text waiting to be drawn by the next render */
+    ArcadeTextQueue text_shown;                          /* Text drawn by the last render (dirty tracking) */
+    int scene_rendered;                                  /* 1 if a scene was rendered since the last update */
+};
+
+static ArcadeContext default_context = {0}; /* Context used by the functions without a ctx parameter */
 
 /* =========================================================================
  * Platform-Specific Input Handling (Windows Only)
@@ -188,20 +285,30 @@ static int arcade_to_vk(unsigned int arcade_key)
 #ifdef _WIN32
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    /* The owning context is passed to CreateWindow and stored in the window's user data */
+    if (msg == WM_NCCREATE)
+    {
+        CREATESTRUCT *create = (CREATESTRUCT *)lParam;
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)create->lpCreateParams);
+    }
+    ArcadeContext *ctx = (ArcadeContext *)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+    if (!ctx)
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+
     switch (msg)
     {
     case WM_KEYDOWN:
     {
         int vk = (int)wParam;
         if (vk < 256)
-            key_states[vk] = 1;
+            ctx->key_states[vk] = 1;
         break;
     }
     case WM_KEYUP:
     {
         int vk = (int)wParam;
         if (vk < 256)
-            key_states[vk] = 0;
+            ctx->key_states[vk] = 0;
         break;
     }
     case WM_PAINT:
@@ -209,14 +316,14 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
         HDC memDC = CreateCompatibleDC(hdc);
-        SelectObject(memDC, state.hbitmap);
-        BitBlt(hdc, 0, 0, state.width, state.height, memDC, 0, 0, SRCCOPY);
+        SelectObject(memDC, ctx->state.hbitmap);
+        BitBlt(hdc, 0, 0, ctx->state.width, ctx->state.height, memDC, 0, 0, SRCCOPY);
         DeleteDC(memDC);
         EndPaint(hwnd, &ps);
         break;
     }
     case WM_DESTROY:
-        state.running = 0;
+        ctx->state.running = 0;
         PostQuitMessage(0);
         break;
     default:
@@ -227,796 +334,6050 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 #endif
 
 /* =========================================================================
- * Core Functions
+ * Platform-Specific Shared Memory Presentation (Linux Only)
  * ========================================================================= */
+#if !defined(_WIN32) && !defined(ARCADE_NO_XSHM)
+static int shm_attach_failed = 0; /* Set by shm_error_handler if XShmAttach is rejected (X error handlers are process-wide) */
 
-int arcade_init(int window_width, int window_height, const char *window_title, uint32_t bg_color)
+static int shm_error_handler(Display *display, XErrorEvent *error)
 {
-#ifdef _WIN32
-    /* Set up Windows-specific window class for the game window */
-    WNDCLASS wc = {0};
-    wc.lpfnWndProc = WndProc;                      /* Assign window procedure for event handling */
-    wc.hInstance = GetModuleHandle(NULL);          /* Get current application instance */
-    wc.lpszClassName = "ArcadeWindow";             /* Name of the window class */
-    wc.hCursor = LoadCursor(NULL, IDC_ARROW);      /* Use standard arrow cursor */
-    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1); /* Default window background */
-    RegisterClass(&wc);
+    /* XShmAttach fails asynchronously (e.g., BadAccess on a remote display) */
+    (void)display;
+    (void)error;
+    shm_attach_failed = 1;
+    return 0;
+}
 
-    /* Create a non-resizable window with specified dimensions */
-    DWORD style = WS_OVERLAPPEDWINDOW & ~WS_MAXIMIZEBOX & ~WS_THICKFRAME;
-    RECT rect = {0, 0, window_width, window_height};
-    AdjustWindowRect(&rect, style, FALSE); /* Adjust window size to account for borders */
-    state.hwnd = CreateWindow("ArcadeWindow", window_title, style,
-                              CW_USEDEFAULT, CW_USEDEFAULT,
-                              rect.right - rect.left, rect.bottom - rect.top,
-                              NULL, NULL, wc.hInstance, NULL);
-    if (!state.hwnd)
-    {
-        fprintf(stderr, "Cannot create window\n");
-        return 1; /* Return error code on failure */
-    }
-    ShowWindow(state.hwnd, SW_SHOW); /* Display the window */
-    UpdateWindow(state.hwnd);        /* Force initial window update */
+static Bool is_shm_completion(Display *display, XEvent *event, XPointer arg)
+{
+    (void)display;
+    return event->type == *(int *)arg;
+}
 
-    state.hdc = GetDC(state.hwnd);
-    state.width = window_width;
-    state.height = window_height;
-    state.bg_color = bg_color;
-    state.running = 1;
+static void destroy_shm_image(ArcadeContext *ctx)
+{
+    /* The segment is not owned by Xlib, so detach it before destroying the image */
+    ctx->state.image->data = NULL;
+    XDestroyImage(ctx->state.image);
+    ctx->state.image = NULL;
+    shmdt(ctx->state.shm_info.shmaddr);
+}
 
-    BITMAPINFO bmi = {0};
-    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
-    bmi.bmiHeader.biWidth = window_width;
-    bmi.bmiHeader.biHeight = -window_height;
-    bmi.bmiHeader.biPlanes = 1;
-    bmi.bmiHeader.biBitCount = 32;
-    bmi.bmiHeader.biCompression = BI_RGB;
-    state.hbitmap = CreateDIBSection(state.hdc, &bmi, DIB_RGB_COLORS, (void **)&state.pixels, NULL, 0);
-    if (!state.hbitmap || !state.pixels)
-    {
-        ReleaseDC(state.hwnd, state.hdc);
-        DestroyWindow(state.hwnd);
-        fprintf(stderr, "Cannot create bitmap\n");
+static int create_shm_image(ArcadeContext *ctx, int width, int height)
+{
+    if (!XShmQueryExtension(ctx->state.display))
         return 1;
-    }
 
-    for (int i = 0; i < window_width * window_height; i++)
+    ctx->state.image = XShmCreateImage(ctx->state.display, DefaultVisual(ctx->state.display, ctx->state.screen),
+                                       DefaultDepth(ctx->state.display, ctx->state.screen), ZPixmap, NULL,
+                                       &ctx->state.shm_info, width, height);
+    if (!ctx->state.image)
+        return 1;
+    /* The renderer indexes pixels as y * width + x, so rows must be tightly packed */
+    if (ctx->state.image->bits_per_pixel != 32 || ctx->state.image->bytes_per_line != width * 4)
     {
-        state.pixels[i] = bg_color;
+        XDestroyImage(ctx->state.image);
+        ctx->state.image = NULL;
+        return 1;
     }
 
-    state.hfont = CreateFont(15, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                             ANSI_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                             DEFAULT_QUALITY, FIXED_PITCH | FF_MODERN, "Courier New");
-    if (!state.hfont)
+    ctx->state.shm_info.shmid = shmget(IPC_PRIVATE, ctx->state.image->bytes_per_line * ctx->state.image->height, IPC_CREAT | 0600);
+    if (ctx->state.shm_info.shmid < 0)
     {
-        DeleteObject(state.hbitmap);
-        ReleaseDC(state.hwnd, state.hdc);
-        DestroyWindow(state.hwnd);
-        fprintf(stderr, "Cannot create font\n");
+        XDestroyImage(ctx->state.image);
+        ctx->state.image = NULL;
         return 1;
     }
-#else
-    state.display = XOpenDisplay(NULL);
-    if (!state.display)
+    ctx->state.shm_info.shmaddr = ctx->state.image->data = shmat(ctx->state.shm_info.shmid, NULL, 0);
+    if (ctx->state.shm_info.shmaddr == (char *)-1)
     {
-        fprintf(stderr, "Cannot open display\n");
+        shmctl(ctx->state.shm_info.shmid, IPC_RMID, NULL);
+        ctx->state.image->data = NULL;
+        XDestroyImage(ctx->state.image);
+        ctx->state.image = NULL;
         return 1;
     }
+    ctx->state.shm_info.readOnly = False;
 
-    state.screen = DefaultScreen(state.display);
-    state.window = XCreateSimpleWindow(state.display, RootWindow(state.display, state.screen),
-                                       100, 100, window_width, window_height, 1,
-                                       BlackPixel(state.display, state.screen),
-                                       WhitePixel(state.display, state.screen));
-    XStoreName(state.display, state.window, window_title);
-    XSelectInput(state.display, state.window, ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask);
-    state.wm_delete = XInternAtom(state.display, "WM_DELETE_WINDOW", False);
-    XSetWMProtocols(state.display, state.window, &state.wm_delete, 1);
-    XMapWindow(state.display, state.window);
+    /* Attach synchronously so a rejected attach is caught here, not at the first present */
+    shm_attach_failed = 0;
+    XErrorHandler old_handler = XSetErrorHandler(shm_error_handler);
+    Status attached = XShmAttach(ctx->state.display, &ctx->state.shm_info);
+    XSync(ctx->state.display, False);
+    XSetErrorHandler(old_handler);
 
-    state.pixels = malloc(window_width * window_height * sizeof(uint32_t));
-    if (!state.pixels)
+    /* Mark the segment for removal now; it stays alive until both sides detach */
+    shmctl(ctx->state.shm_info.shmid, IPC_RMID, NULL);
+    if (!attached || shm_attach_failed)
     {
-        XCloseDisplay(state.display);
-        fprintf(stderr, "Cannot allocate pixels\n");
+        destroy_shm_image(ctx);
         return 1;
     }
-    state.width = window_width;
-    state.height = window_height;
-    state.bg_color = bg_color;
-    state.running = 1;
 
-    state.font = XLoadQueryFont(state.display, "9x15");
-    if (!state.font)
+    ctx->state.pixels = (uint32_t *)ctx->state.image->data;
+    ctx->state.shm_completion = XShmGetEventBase(ctx->state.display) + ShmCompletion;
+    ctx->state.shm_pending = 0;
+    return 0;
+}
+
+static void wait_for_shm(ArcadeContext *ctx)
+{
+    /* Block until the server has finished reading everything presented so far */
+    XEvent event;
+    while (ctx->state.shm_pending > 0)
     {
-        fprintf(stderr, "Cannot load font 9x15\n");
-        XCloseDisplay(state.display);
-        free(state.pixels);
-        return 1;
+        XIfEvent(ctx->state.display, &event, is_shm_completion, (XPointer)&ctx->state.shm_completion);
+        ctx->state.shm_pending--;
     }
+}
+#endif
+
+/* =========================================================================
+ * Injected Input Queue
+ * ========================================================================= */
 
-    state.image = XCreateImage(state.display, DefaultVisual(state.display, state.screen),
-                               DefaultDepth(state.display, state.screen), ZPixmap, 0,
-                               (char *)state.pixels, window_width, window_height, 32, 0);
-    if (!state.image)
+static int key_index(unsigned int key_val)
+{
+    /* Maps an arcade key code to its slot in key_states */
+#ifdef _WIN32
+    return arcade_to_vk(key_val);
+#else
+    return key_val & 0xFF;
+#endif
+}
+
+static void apply_input_queue(ArcadeContext *ctx)
+{
+    /* Apply events that are due this frame, keeping later ones in order */
+    int kept = 0;
+    for (int i = 0; i < ctx->input_count; i++)
     {
-        free(state.pixels);
-        XCloseDisplay(state.display);
-        fprintf(stderr, "Cannot create XImage\n");
-        return 1;
+        if (ctx->input_queue[i].frame <= ctx->frame_counter)
+            ctx->key_states[key_index(ctx->input_queue[i].key_val)] = ctx->input_queue[i].pressed ? 1 : 0;
+        else
+            ctx->input_queue[kept++] = ctx->input_queue[i];
     }
+    ctx->input_count = kept;
+}
+
+/* =========================================================================
+ * Pixel Kernels
+ * ========================================================================= */
+
+/* SIMD variants are compiled with per-function target attributes, so no
+ * -msse2/-mavx2 flags are needed; the best one is picked at startup via CPUID. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(ARCADE_NO_SIMD)
+#define ARCADE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define ARCADE_PIXEL_ALIGNMENT 64 /* Byte alignment of pixel buffers (cache line, >= AVX2 vector) */
+#define ARCADE_ROTATE_TILE 32      /* Square tile, in pixels, walked by the quarter-turn kernels (multiple of 8) */
 
-    state.gc = XCreateGC(state.display, state.window, 0, NULL);
-    if (!state.gc)
+/* One screen span of an affine sprite, walked through the source image in 16.16 fixed point */
+typedef struct
+{
+    const uint32_t *pixels; /* Source image */
+    int stride;             /* Source pixels per row */
+    int width, height;      /* Source size; samples are clamped to it */
+    int32_t u, v;           /* Source position of the first screen pixel */
+    int32_t du, dv;         /* Source step per screen pixel */
+} ArcadeAffineSpan;
+
+typedef struct
+{
+    void (*fill)(uint32_t *dst, int count, uint32_t color);                /* Set count pixels to color */
+    void (*blend)(uint32_t *dst, const uint32_t *src, int count);          /* Source-over of premultiplied src onto dst */
+    uint32_t (*premultiply)(uint32_t *dst, const uint8_t *src, int count); /* RGBA bytes to premultiplied ARGB; returns AND of alphas */
+    void (*reverse)(uint32_t *dst, const uint32_t *src, int count);        /* dst = src mirrored; dst may be src */
+    /* Quarter turn, clockwise or not, into a packed height-wide dst */
+    void (*rotate)(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int clockwise);
+    void (*sample_nearest)(uint32_t *dst, const ArcadeAffineSpan *span, int count);  /* Nearest samples along a span */
+    void (*sample_bilinear)(uint32_t *dst, const ArcadeAffineSpan *span, int count); /* Bilinear samples along a span */
+    /* Box (x0, y0, x1, y1) against count boxes stored as arrays; sets hit bits, returns the hit count */
+    int (*overlap_boxes)(const float *box, const float *x, const float *y, const float *w, const float *h, int count,
+                         uint32_t *hits);
+} ArcadeKernels;
+
+static void fill_span_scalar(uint32_t *dst, int count, uint32_t color)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = color;
+}
+
+static uint32_t premultiply_channel(uint32_t c, uint32_t a)
+{
+    /* Exact round(c * a / 255) without a division */
+    uint32_t t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static uint32_t blend_pixel(uint32_t dst, uint32_t src)
+{
+    /* Premultiplied source-over: dst = src + dst * (255 - src_alpha) / 255 */
+    uint32_t a = src >> 24;
+    if (a == 255)
+        return src;
+    if (a == 0)
+        return dst;
+    uint32_t inv = 255 - a;
+    uint32_t rb = (dst & 0x00FF00FF) * inv + 0x00800080;
+    rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    uint32_t ag = ((dst >> 8) & 0x00FF00FF) * inv + 0x00800080;
+    ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+    return src + rb + ag;
+}
+
+static void blend_span_scalar(uint32_t *dst, const uint32_t *src, int count)
+{
+    for (int i = 0; i < count; i++)
+        dst[i] = blend_pixel(dst[i], src[i]);
+}
+
+static uint32_t premultiply_span_scalar(uint32_t *dst, const uint8_t *src, int count)
+{
+    /* dst may alias src: each pixel is read completely before it is written */
+    uint32_t alpha = 255;
+    for (int i = 0; i < count; i++, src += 4)
     {
-        XDestroyImage(state.image);
-        XCloseDisplay(state.display);
-        fprintf(stderr, "Cannot create GC\n");
-        return 1;
+        uint32_t a = src[3];
+        alpha &= a;
+        dst[i] = (premultiply_channel(src[0], a) << 16) | (premultiply_channel(src[1], a) << 8) |
+                 premultiply_channel(src[2], a) | (a << 24);
     }
+    return alpha;
+}
 
-    for (int i = 0; i < state.width * state.height; i++)
+static void reverse_span_scalar(uint32_t *dst, const uint32_t *src, int count)
+{
+    /* dst may be src: pixels are exchanged in pairs from both ends */
+    int l = 0, r = count - 1;
+    for (; l < r; l++, r--)
     {
-        state.pixels[i] = bg_color;
+        uint32_t t = src[l];
+        dst[l] = src[r];
+        dst[r] = t;
     }
-#endif
-    return 0;
+    if (l == r)
+        dst[l] = src[l];
 }
 
-void arcade_quit(void)
+static void rotate_region(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int clockwise,
+                          int row0, int row1, int col0, int col1)
 {
-#ifdef _WIN32
-    if (state.hfont)
+    /* Quarter-turns the source rows [row0, row1) x columns [col0, col1) into dst */
+    for (int r = row0; r < row1; r++)
     {
-        DeleteObject(state.hfont);
-        state.hfont = NULL;
+        const uint32_t *in = src + (size_t)r * src_stride;
+        if (clockwise)
+            for (int c = col0; c < col1; c++)
+                dst[(size_t)c * height + (height - 1 - r)] = in[c];
+        else
+            for (int c = col0; c < col1; c++)
+                dst[(size_t)(width - 1 - c) * height + r] = in[c];
     }
-    if (state.hbitmap)
+}
+
+static void sample_nearest_scalar(uint32_t *dst, const ArcadeAffineSpan *span, int count)
+{
+    for (int i = 0; i < count; i++)
     {
-        DeleteObject(state.hbitmap);
-        state.hbitmap = NULL;
-        state.pixels = NULL;
+        int x = (span->u + i * span->du) >> 16, y = (span->v + i * span->dv) >> 16;
+        x = x < 0 ? 0 : x >= span->width ? span->width - 1 : x;
+        y = y < 0 ? 0 : y >= span->height ? span->height - 1 : y;
+        dst[i] = span->pixels[(size_t)y * span->stride + x];
     }
-    if (state.hdc)
+}
+
+static uint32_t lerp_pixel(uint32_t a, uint32_t b, uint32_t f)
+{
+    /* a + (b - a) * f / 256 on two channels per multiply; f is 0..255 */
+    uint32_t rb = (((a & 0x00FF00FF) * (256 - f) + (b & 0x00FF00FF) * f) >> 8) & 0x00FF00FF;
+    uint32_t ag = (((a >> 8) & 0x00FF00FF) * (256 - f) + ((b >> 8) & 0x00FF00FF) * f) & 0xFF00FF00;
+    return rb | ag;
+}
+
+static void sample_bilinear_scalar(uint32_t *dst, const ArcadeAffineSpan *span, int count)
+{
+    /* u, v locate the top-left of the four taps; taps outside the image are
+     * transparent, which fades the edges out smoothly */
+    for (int i = 0; i < count; i++)
     {
-        ReleaseDC(state.hwnd, state.hdc);
-        state.hdc = NULL;
+        int32_t u = span->u + i * span->du, v = span->v + i * span->dv;
+        int x = u >> 16, y = v >> 16;
+        uint32_t fx = (u & 0xFFFF) >> 8, fy = (v & 0xFFFF) >> 8;
+        uint32_t tap[4] = {0, 0, 0, 0};
+        for (int k = 0; k < 4; k++)
+        {
+            int tx = x + (k & 1), ty = y + (k >> 1);
+            if (tx >= 0 && tx < span->width && ty >= 0 && ty < span->height)
+                tap[k] = span->pixels[(size_t)ty * span->stride + tx];
+        }
+        dst[i] = lerp_pixel(lerp_pixel(tap[0], tap[1], fx), lerp_pixel(tap[2], tap[3], fx), fy);
     }
-    if (state.hwnd)
+}
+
+static int overlap_box_range(const float *box, const float *x, const float *y, const float *w, const float *h, int start,
+                             int count, uint32_t *hits)
+{
+    /* Boxes [start, count) against box (x0, y0, x1, y1); NaN coordinates never
+     * compare true, so such boxes never hit. start is a multiple of 4. */
+    int found = 0;
+    for (int i = start; i < count; i++)
     {
-        DestroyWindow(state.hwnd);
-        state.hwnd = NULL;
+        if ((i & 31) == 0)
+            hits[i >> 5] = 0;
+        if (box[0] < x[i] + w[i] && box[2] > x[i] && box[1] < y[i] + h[i] && box[3] > y[i])
+        {
+            hits[i >> 5] |= 1u << (i & 31);
+            found++;
+        }
     }
-#else
-    if (state.font)
+    return found;
+}
+
+static int overlap_boxes_scalar(const float *box, const float *x, const float *y, const float *w, const float *h,
+                                int count, uint32_t *hits)
+{
+    return overlap_box_range(box, x, y, w, h, 0, count, hits);
+}
+
+static void rotate_quarter_scalar(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int clockwise)
+{
+    /* Tiled so the column-wise writes stay within a few cache lines per tile */
+    for (int r = 0; r < height; r += ARCADE_ROTATE_TILE)
     {
-        XFreeFont(state.display, state.font);
-        state.font = NULL;
+        int r_end = r + ARCADE_ROTATE_TILE < height ? r + ARCADE_ROTATE_TILE : height;
+        for (int c = 0; c < width; c += ARCADE_ROTATE_TILE)
+            rotate_region(dst, src, width, height, src_stride, clockwise, r, r_end, c,
+                          c + ARCADE_ROTATE_TILE < width ? c + ARCADE_ROTATE_TILE : width);
     }
-    if (state.image)
+}
+
+#ifdef ARCADE_X86_SIMD
+__attribute__((target("sse2"))) static void fill_span_sse2(uint32_t *dst, int count, uint32_t color)
+{
+    /* Scalar head up to a 16-byte boundary, then aligned 16-pixel stores */
+    while (count > 0 && ((uintptr_t)dst & 15))
     {
-        XDestroyImage(state.image);
-        state.image = NULL;
-        state.pixels = NULL;
+        *dst++ = color;
+        count--;
     }
-    if (state.gc)
+    __m128i v = _mm_set1_epi32((int)color);
+    for (; count >= 16; count -= 16, dst += 16)
     {
-        XFreeGC(state.display, state.gc);
-        state.gc = NULL;
+        _mm_store_si128((__m128i *)dst, v);
+        _mm_store_si128((__m128i *)(dst + 4), v);
+        _mm_store_si128((__m128i *)(dst + 8), v);
+        _mm_store_si128((__m128i *)(dst + 12), v);
     }
-    if (state.display && state.window)
+    for (; count >= 4; count -= 4, dst += 4)
+        _mm_store_si128((__m128i *)dst, v);
+    fill_span_scalar(dst, count, color);
+}
+
+__attribute__((target("avx2"))) static void fill_span_avx2(uint32_t *dst, int count, uint32_t color)
+{
+    /* Scalar head up to a 32-byte boundary, then aligned 32-pixel stores */
+    while (count > 0 && ((uintptr_t)dst & 31))
     {
-        XDestroyWindow(state.display, state.window);
-        state.window = 0;
+        *dst++ = color;
+        count--;
     }
-    if (state.display)
+    __m256i v = _mm256_set1_epi32((int)color);
+    for (; count >= 32; count -= 32, dst += 32)
     {
-        XCloseDisplay(state.display);
-        state.display = NULL;
+        _mm256_store_si256((__m256i *)dst, v);
+        _mm256_store_si256((__m256i *)(dst + 8), v);
+        _mm256_store_si256((__m256i *)(dst + 16), v);
+        _mm256_store_si256((__m256i *)(dst + 24), v);
     }
-#endif
+    for (; count >= 8; count -= 8, dst += 8)
+        _mm256_store_si256((__m256i *)dst, v);
+    fill_span_scalar(dst, count, color);
 }
 
-int arcade_update(void)
+__attribute__((target("sse2"))) static __m128i blend_4_sse2(__m128i d, __m128i s)
 {
-#ifdef _WIN32
-    MSG msg;
-    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+    /* Widen to 16 bits per channel, scale dst by the inverse source alpha, add src */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c128 = _mm_set1_epi16(128);
+    __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+    __m128i dlo = _mm_unpacklo_epi8(d, zero), dhi = _mm_unpackhi_epi8(d, zero);
+    __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xFF), 0xFF);
+    __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xFF), 0xFF);
+    __m128i tlo = _mm_add_epi16(_mm_mullo_epi16(dlo, _mm_sub_epi16(c255, alo)), c128);
+    __m128i thi = _mm_add_epi16(_mm_mullo_epi16(dhi, _mm_sub_epi16(c255, ahi)), c128);
+    tlo = _mm_srli_epi16(_mm_add_epi16(tlo, _mm_srli_epi16(tlo, 8)), 8);
+    thi = _mm_srli_epi16(_mm_add_epi16(thi, _mm_srli_epi16(thi, 8)), 8);
+    return _mm_add_epi8(s, _mm_packus_epi16(tlo, thi));
+}
+
+__attribute__((target("sse2"))) static void blend_span_sse2(uint32_t *dst, const uint32_t *src, int count)
+{
+    /* 4 pixels per step; fully transparent and fully opaque groups skip the math */
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
     {
-        if (msg.message == WM_QUIT)
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, _mm_setzero_si128())) == 0xFFFF)
+            continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), alpha_mask)) == 0xFFFF)
         {
-            state.running = 0;
-            return 0;
+            _mm_storeu_si128((__m128i *)(dst + i), s);
+            continue;
         }
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), blend_4_sse2(d, s));
     }
-#else
-    XEvent event;
-    while (XPending(state.display))
+    blend_span_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2"))) static void blend_span_avx2(uint32_t *dst, const uint32_t *src, int count)
+{
+    /* 8 pixels per step; same arithmetic as blend_4_sse2 on 256-bit lanes */
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
     {
-        XNextEvent(state.display, &event);
-        if (event.type == ClientMessage && event.xclient.data.l[0] == state.wm_delete)
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        if (_mm256_testz_si256(s, s))
+            continue;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alpha_mask), alpha_mask)) == -1)
         {
-            state.running = 0;
-            return 0;
+            _mm256_storeu_si256((__m256i *)(dst + i), s);
+            continue;
         }
-        else if (event.type == KeyPress)
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i slo = _mm256_unpacklo_epi8(s, zero), shi = _mm256_unpackhi_epi8(s, zero);
+        __m256i dlo = _mm256_unpacklo_epi8(d, zero), dhi = _mm256_unpackhi_epi8(d, zero);
+        __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(slo, 0xFF), 0xFF);
+        __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(shi, 0xFF), 0xFF);
+        __m256i tlo = _mm256_add_epi16(_mm256_mullo_epi16(dlo, _mm256_sub_epi16(c255, alo)), c128);
+        __m256i thi = _mm256_add_epi16(_mm256_mullo_epi16(dhi, _mm256_sub_epi16(c255, ahi)), c128);
+        tlo = _mm256_srli_epi16(_mm256_add_epi16(tlo, _mm256_srli_epi16(tlo, 8)), 8);
+        thi = _mm256_srli_epi16(_mm256_add_epi16(thi, _mm256_srli_epi16(thi, 8)), 8);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi8(s, _mm256_packus_epi16(tlo, thi)));
+    }
+    blend_span_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("ssse3"))) static uint32_t premultiply_span_ssse3(uint32_t *dst, const uint8_t *src, int count)
+{
+    /* 4 pixels per step: one byte shuffle turns RGBA into ARGB, then the color
+     * channels are scaled by alpha with the same rounding as premultiply_channel */
+    const __m128i swizzle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    __m128i alpha_and = alpha_mask;
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i * 4)), swizzle);
+        __m128i a = _mm_and_si128(s, alpha_mask);
+        alpha_and = _mm_and_si128(alpha_and, a);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(a, alpha_mask)) != 0xFFFF)
         {
-            KeySym keysym = XLookupKeysym(&event.xkey, 0);
-            key_states[keysym & 0xFF] = 1;
+            __m128i lo = _mm_unpacklo_epi8(s, zero), hi = _mm_unpackhi_epi8(s, zero);
+            __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+            __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+            lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), c128);
+            hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), c128);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            s = _mm_or_si128(_mm_andnot_si128(alpha_mask, _mm_packus_epi16(lo, hi)), a);
         }
-        else if (event.type == KeyRelease)
+        _mm_storeu_si128((__m128i *)(dst + i), s);
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, alpha_and);
+    uint32_t alpha = (lanes[0] & lanes[1] & lanes[2] & lanes[3]) >> 24;
+    return alpha & premultiply_span_scalar(dst + i, src + i * 4, count - i);
+}
+
+__attribute__((target("avx2"))) static uint32_t premultiply_span_avx2(uint32_t *dst, const uint8_t *src, int count)
+{
+    /* 8 pixels per step; same arithmetic as premultiply_span_ssse3 (the shuffle stays within 128-bit lanes) */
+    const __m256i swizzle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+    __m256i alpha_and = alpha_mask;
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i s = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + i * 4)), swizzle);
+        __m256i a = _mm256_and_si256(s, alpha_mask);
+        alpha_and = _mm256_and_si256(alpha_and, a);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, alpha_mask)) != -1)
         {
-            KeySym keysym = XLookupKeysym(&event.xkey, 0);
-            key_states[keysym & 0xFF] = 0;
+            __m256i lo = _mm256_unpacklo_epi8(s, zero), hi = _mm256_unpackhi_epi8(s, zero);
+            __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xFF), 0xFF);
+            __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xFF), 0xFF);
+            lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alo), c128);
+            hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, ahi), c128);
+            lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+            hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+            s = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, _mm256_packus_epi16(lo, hi)), a);
         }
+        _mm256_storeu_si256((__m256i *)(dst + i), s);
     }
-#endif
-    global_frame_counter++;
-    return 1;
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, alpha_and);
+    uint32_t alpha = lanes[0] & lanes[1] & lanes[2] & lanes[3] & lanes[4] & lanes[5] & lanes[6] & lanes[7];
+    return (alpha >> 24) & premultiply_span_scalar(dst + i, src + i * 4, count - i);
 }
 
-int arcade_running(void)
+__attribute__((target("sse2"))) static void reverse_span_sse2(uint32_t *dst, const uint32_t *src, int count)
 {
-    return state.running;
+    /* 4 pixels from each end per step; both are loaded before either is stored, so dst may be src */
+    int l = 0, r = count;
+    for (; r - l >= 8; l += 4, r -= 4)
+    {
+        __m128i left = _mm_loadu_si128((const __m128i *)(src + l));
+        __m128i right = _mm_loadu_si128((const __m128i *)(src + r - 4));
+        _mm_storeu_si128((__m128i *)(dst + l), _mm_shuffle_epi32(right, _MM_SHUFFLE(0, 1, 2, 3)));
+        _mm_storeu_si128((__m128i *)(dst + r - 4), _mm_shuffle_epi32(left, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+    reverse_span_scalar(dst + l, src + l, r - l);
 }
 
-void arcade_set_running(int value)
+__attribute__((target("avx2"))) static void reverse_span_avx2(uint32_t *dst, const uint32_t *src, int count)
 {
-    state.running = value;
+    /* Same scheme as reverse_span_sse2 with 8 pixels from each end */
+    const __m256i mirror = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    int l = 0, r = count;
+    for (; r - l >= 16; l += 8, r -= 8)
+    {
+        __m256i left = _mm256_loadu_si256((const __m256i *)(src + l));
+        __m256i right = _mm256_loadu_si256((const __m256i *)(src + r - 8));
+        _mm256_storeu_si256((__m256i *)(dst + l), _mm256_permutevar8x32_epi32(right, mirror));
+        _mm256_storeu_si256((__m256i *)(dst + r - 8), _mm256_permutevar8x32_epi32(left, mirror));
+    }
+    reverse_span_sse2(dst + l, src + l, r - l);
 }
 
-void arcade_sleep(unsigned int milliseconds)
+__attribute__((target("sse2"))) static void rotate_quarter_sse2(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int clockwise)
 {
-#ifdef _WIN32
-    Sleep(milliseconds);
-#else
-    usleep(milliseconds * 1000); /* Convert ms to microseconds */
-#endif
+    /* Whole 4x4 blocks are transposed in registers, tile by tile; loading the rows
+     * bottom-up for a clockwise turn leaves each output row in order */
+    int full_width = width & ~3, full_height = height & ~3;
+    ptrdiff_t step = clockwise ? height : -height;
+    for (int tr = 0; tr < full_height; tr += ARCADE_ROTATE_TILE)
+    {
+        int r_end = tr + ARCADE_ROTATE_TILE < full_height ? tr + ARCADE_ROTATE_TILE : full_height;
+        for (int tc = 0; tc < full_width; tc += ARCADE_ROTATE_TILE)
+        {
+            int c_end = tc + ARCADE_ROTATE_TILE < full_width ? tc + ARCADE_ROTATE_TILE : full_width;
+            for (int r = tr; r < r_end; r += 4)
+                for (int c = tc; c < c_end; c += 4)
+                {
+                    const uint32_t *in = src + (size_t)r * src_stride + c;
+                    ptrdiff_t row = clockwise ? -(ptrdiff_t)src_stride : src_stride;
+                    if (clockwise)
+                        in += (size_t)3 * src_stride;
+                    __m128i r0 = _mm_loadu_si128((const __m128i *)in);
+                    __m128i r1 = _mm_loadu_si128((const __m128i *)(in + row));
+                    __m128i r2 = _mm_loadu_si128((const __m128i *)(in + 2 * row));
+                    __m128i r3 = _mm_loadu_si128((const __m128i *)(in + 3 * row));
+                    __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpackhi_epi32(r0, r1);
+                    __m128i t2 = _mm_unpacklo_epi32(r2, r3), t3 = _mm_unpackhi_epi32(r2, r3);
+                    uint32_t *out = clockwise ? dst + (size_t)c * height + (height - 4 - r)
+                                              : dst + (size_t)(width - 1 - c) * height + r;
+                    _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi64(t0, t2));
+                    _mm_storeu_si128((__m128i *)(out + step), _mm_unpackhi_epi64(t0, t2));
+                    _mm_storeu_si128((__m128i *)(out + 2 * step), _mm_unpacklo_epi64(t1, t3));
+                    _mm_storeu_si128((__m128i *)(out + 3 * step), _mm_unpackhi_epi64(t1, t3));
+                }
+        }
+    }
+    rotate_region(dst, src, width, height, src_stride, clockwise, 0, height, full_width, width);
+    rotate_region(dst, src, width, height, src_stride, clockwise, full_height, height, 0, full_width);
 }
 
-float arcade_delta_time(void)
+__attribute__((target("avx2"))) static void rotate_quarter_avx2(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int clockwise)
 {
-    static double last_time = 0.0; /* Store time of the last frame */
-    double current_time = 0.0;     /* Current frame time */
-    float delta_time;
-
-#ifdef _WIN32
-    /* Use high-resolution performance counter for precise timing on Windows */
-    LARGE_INTEGER frequency, counter;
-    QueryPerformanceFrequency(&frequency); /* Get ticks per second */
-    QueryPerformanceCounter(&counter);     /* Get current tick count */
-    current_time = (double)counter.QuadPart / frequency.QuadPart;
-#else
-    struct timespec ts;
-    int clock_result = -1;
-#ifdef CLOCK_MONOTONIC
-    /* Prefer CLOCK_MONOTONIC for consistent timing (not affected by system clock changes) */
-    clock_result = clock_gettime(CLOCK_MONOTONIC, &ts);
-    if (clock_result == 0)
+    /* Same scheme as rotate_quarter_sse2 with 8x8 blocks */
+    int full_width = width & ~7, full_height = height & ~7;
+    ptrdiff_t step = clockwise ? height : -height;
+    for (int tr = 0; tr < full_height; tr += ARCADE_ROTATE_TILE)
     {
-        current_time = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+        int r_end = tr + ARCADE_ROTATE_TILE < full_height ? tr + ARCADE_ROTATE_TILE : full_height;
+        for (int tc = 0; tc < full_width; tc += ARCADE_ROTATE_TILE)
+        {
+            int c_end = tc + ARCADE_ROTATE_TILE < full_width ? tc + ARCADE_ROTATE_TILE : full_width;
+            for (int r = tr; r < r_end; r += 8)
+                for (int c = tc; c < c_end; c += 8)
+                {
+                    const uint32_t *in = src + (size_t)r * src_stride + c;
+                    ptrdiff_t row = clockwise ? -(ptrdiff_t)src_stride : src_stride;
+                    if (clockwise)
+                        in += (size_t)7 * src_stride;
+                    __m256i v[8];
+                    for (int k = 0; k < 8; k++)
+                        v[k] = _mm256_loadu_si256((const __m256i *)(in + k * row));
+                    for (int k = 0; k < 8; k += 4)
+                    {
+                        __m256i t0 = _mm256_unpacklo_epi32(v[k], v[k + 1]), t1 = _mm256_unpackhi_epi32(v[k], v[k + 1]);
+                        __m256i t2 = _mm256_unpacklo_epi32(v[k + 2], v[k + 3]), t3 = _mm256_unpackhi_epi32(v[k + 2], v[k + 3]);
+                        v[k] = _mm256_unpacklo_epi64(t0, t2);
+                        v[k + 1] = _mm256_unpackhi_epi64(t0, t2);
+                        v[k + 2] = _mm256_unpacklo_epi64(t1, t3);
+                        v[k + 3] = _mm256_unpackhi_epi64(t1, t3);
+                    }
+                    uint32_t *out = clockwise ? dst + (size_t)c * height + (height - 8 - r)
+                                              : dst + (size_t)(width - 1 - c) * height + r;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        /* Low halves hold columns 0-3 of the block, high halves columns 4-7 */
+                        _mm256_storeu_si256((__m256i *)(out + k * step), _mm256_permute2x128_si256(v[k], v[k + 4], 0x20));
+                        _mm256_storeu_si256((__m256i *)(out + (k + 4) * step), _mm256_permute2x128_si256(v[k], v[k + 4], 0x31));
+                    }
+                }
+        }
     }
-#else
-#ifdef CLOCK_REALTIME
-    /* Fallback to CLOCK_REALTIME (less reliable due to system clock adjustments) */
-    clock_result = clock_gettime(CLOCK_REALTIME, &ts);
-    if (clock_result == 0)
+    rotate_region(dst, src, width, height, src_stride, clockwise, 0, height, full_width, width);
+    rotate_region(dst, src, width, height, src_stride, clockwise, full_height, height, 0, full_width);
+}
+
+__attribute__((target("avx2"))) static void sample_nearest_avx2(uint32_t *dst, const ArcadeAffineSpan *span, int count)
+{
+    /* 8 source positions per step, clamped like sample_nearest_scalar, then one gather */
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max_x = _mm256_set1_epi32(span->width - 1), max_y = _mm256_set1_epi32(span->height - 1);
+    const __m256i stride = _mm256_set1_epi32(span->stride);
+    __m256i u = _mm256_add_epi32(_mm256_set1_epi32(span->u), _mm256_mullo_epi32(lane, _mm256_set1_epi32(span->du)));
+    __m256i v = _mm256_add_epi32(_mm256_set1_epi32(span->v), _mm256_mullo_epi32(lane, _mm256_set1_epi32(span->dv)));
+    const __m256i step_u = _mm256_set1_epi32(span->du * 8), step_v = _mm256_set1_epi32(span->dv * 8);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
     {
-        current_time = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
-        fprintf(stderr, "Warning: Using CLOCK_REALTIME (less reliable for timing)\n");
+        __m256i x = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(u, 16), zero), max_x);
+        __m256i y = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(v, 16), zero), max_y);
+        __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_i32gather_epi32((const int *)span->pixels, index, 4));
+        u = _mm256_add_epi32(u, step_u);
+        v = _mm256_add_epi32(v, step_v);
     }
-#else
-    /* Fallback to gettimeofday if no POSIX clocks are available */
-    fprintf(stderr, "Warning: No POSIX clocks available, falling back to gettimeofday\n");
-    struct timeval tv;
-    if (gettimeofday(&tv, NULL) == 0)
+    ArcadeAffineSpan rest = *span;
+    rest.u += i * span->du;
+    rest.v += i * span->dv;
+    sample_nearest_scalar(dst + i, &rest, count - i);
+}
+
+__attribute__((target("avx2"))) static __m256i lerp_8_avx2(__m256i a, __m256i b, __m256i f)
+{
+    /* lerp_pixel on 8 pixels; f holds each pixel's weight in both 16-bit halves */
+    const __m256i low = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(256), f);
+    __m256i rb = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(a, low), inv),
+                                  _mm256_mullo_epi16(_mm256_and_si256(b, low), f));
+    __m256i ag = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(a, 8), low), inv),
+                                  _mm256_mullo_epi16(_mm256_and_si256(_mm256_srli_epi16(b, 8), low), f));
+    return _mm256_or_si256(_mm256_srli_epi16(rb, 8), _mm256_andnot_si256(low, ag));
+}
+
+__attribute__((target("avx2"))) static void sample_bilinear_avx2(uint32_t *dst, const ArcadeAffineSpan *span, int count)
+{
+    /* Same arithmetic as sample_bilinear_scalar: four gathers with clamped indices,
+     * taps outside the image zeroed by mask, then three 8-pixel lerps */
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1);
+    const __m256i width = _mm256_set1_epi32(span->width), height = _mm256_set1_epi32(span->height);
+    const __m256i max_x = _mm256_sub_epi32(width, one), max_y = _mm256_sub_epi32(height, one);
+    const __m256i stride = _mm256_set1_epi32(span->stride);
+    const __m256i frac = _mm256_set1_epi32(0xFF00);
+    __m256i u = _mm256_add_epi32(_mm256_set1_epi32(span->u), _mm256_mullo_epi32(lane, _mm256_set1_epi32(span->du)));
+    __m256i v = _mm256_add_epi32(_mm256_set1_epi32(span->v), _mm256_mullo_epi32(lane, _mm256_set1_epi32(span->dv)));
+    const __m256i step_u = _mm256_set1_epi32(span->du * 8), step_v = _mm256_set1_epi32(span->dv * 8);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
     {
-        current_time = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+        __m256i x0 = _mm256_srai_epi32(u, 16), y0 = _mm256_srai_epi32(v, 16);
+        __m256i x1 = _mm256_add_epi32(x0, one), y1 = _mm256_add_epi32(y0, one);
+        /* Taps outside the image read a clamped pixel and are then masked to 0 */
+        __m256i in_x0 = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, x0), _mm256_cmpgt_epi32(width, x0));
+        __m256i in_x1 = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, x1), _mm256_cmpgt_epi32(width, x1));
+        __m256i in_y0 = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, y0), _mm256_cmpgt_epi32(height, y0));
+        __m256i in_y1 = _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, y1), _mm256_cmpgt_epi32(height, y1));
+        __m256i cx0 = _mm256_min_epi32(_mm256_max_epi32(x0, zero), max_x);
+        __m256i cx1 = _mm256_min_epi32(_mm256_max_epi32(x1, zero), max_x);
+        __m256i row0 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(y0, zero), max_y), stride);
+        __m256i row1 = _mm256_mullo_epi32(_mm256_min_epi32(_mm256_max_epi32(y1, zero), max_y), stride);
+        const int *base = (const int *)span->pixels;
+        __m256i t00 = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_add_epi32(row0, cx0), 4), _mm256_and_si256(in_x0, in_y0));
+        __m256i t10 = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_add_epi32(row0, cx1), 4), _mm256_and_si256(in_x1, in_y0));
+        __m256i t01 = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_add_epi32(row1, cx0), 4), _mm256_and_si256(in_x0, in_y1));
+        __m256i t11 = _mm256_and_si256(_mm256_i32gather_epi32(base, _mm256_add_epi32(row1, cx1), 4), _mm256_and_si256(in_x1, in_y1));
+        /* (c & 0xFF00) >> 8 is the weight; copy it into the upper 16 bits too */
+        __m256i fx = _mm256_srli_epi32(_mm256_and_si256(u, frac), 8);
+        __m256i fy = _mm256_srli_epi32(_mm256_and_si256(v, frac), 8);
+        fx = _mm256_or_si256(fx, _mm256_slli_epi32(fx, 16));
+        fy = _mm256_or_si256(fy, _mm256_slli_epi32(fy, 16));
+        __m256i top = lerp_8_avx2(t00, t10, fx), bottom = lerp_8_avx2(t01, t11, fx);
+        _mm256_storeu_si256((__m256i *)(dst + i), lerp_8_avx2(top, bottom, fy));
+        u = _mm256_add_epi32(u, step_u);
+        v = _mm256_add_epi32(v, step_v);
     }
-    else
+    ArcadeAffineSpan rest = *span;
+    rest.u += i * span->du;
+    rest.v += i * span->dv;
+    sample_bilinear_scalar(dst + i, &rest, count - i);
+}
+
+__attribute__((target("sse2"))) static int overlap_boxes_sse2(const float *box, const float *x, const float *y,
+                                                            const float *w, const float *h, int count, uint32_t *hits)
+{
+    /* 4 boxes per step; each movemask is 4 bits of the hit mask */
+    const __m128 x0 = _mm_set1_ps(box[0]), y0 = _mm_set1_ps(box[1]), x1 = _mm_set1_ps(box[2]), y1 = _mm_set1_ps(box[3]);
+    int found = 0, i = 0;
+    for (; i + 4 <= count; i += 4)
     {
-        fprintf(stderr, "Error: gettimeofday failed\n");
-        current_time = 0.0;
+        __m128 bx = _mm_loadu_ps(x + i), by = _mm_loadu_ps(y + i);
+        __m128 in_x = _mm_and_ps(_mm_cmplt_ps(x0, _mm_add_ps(bx, _mm_loadu_ps(w + i))), _mm_cmpgt_ps(x1, bx));
+        __m128 in_y = _mm_and_ps(_mm_cmplt_ps(y0, _mm_add_ps(by, _mm_loadu_ps(h + i))), _mm_cmpgt_ps(y1, by));
+        uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_and_ps(in_x, in_y));
+        if ((i & 31) == 0)
+            hits[i >> 5] = bits;
+        else
+            hits[i >> 5] |= bits << (i & 31);
+        found += __builtin_popcount(bits);
     }
-#endif
-#endif
-    if (clock_result != 0 && current_time == 0.0)
+    return found + overlap_box_range(box, x, y, w, h, i, count, hits);
+}
+
+__attribute__((target("avx2"))) static int overlap_boxes_avx2(const float *box, const float *x, const float *y,
+                                                            const float *w, const float *h, int count, uint32_t *hits)
+{
+    /* Same as overlap_boxes_sse2 with 8 boxes per step; ordered compares keep NaN boxes out */
+    const __m256 x0 = _mm256_set1_ps(box[0]), y0 = _mm256_set1_ps(box[1]);
+    const __m256 x1 = _mm256_set1_ps(box[2]), y1 = _mm256_set1_ps(box[3]);
+    int found = 0, i = 0;
+    for (; i + 8 <= count; i += 8)
     {
-        fprintf(stderr, "Warning: clock_gettime failed, falling back to gettimeofday\n");
-        struct timeval tv;
-        if (gettimeofday(&tv, NULL) == 0)
-        {
-            current_time = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
-        }
+        __m256 bx = _mm256_loadu_ps(x + i), by = _mm256_loadu_ps(y + i);
+        __m256 in_x = _mm256_and_ps(_mm256_cmp_ps(x0, _mm256_add_ps(bx, _mm256_loadu_ps(w + i)), _CMP_LT_OQ),
+                                    _mm256_cmp_ps(x1, bx, _CMP_GT_OQ));
+        __m256 in_y = _mm256_and_ps(_mm256_cmp_ps(y0, _mm256_add_ps(by, _mm256_loadu_ps(h + i)), _CMP_LT_OQ),
+                                    _mm256_cmp_ps(y1, by, _CMP_GT_OQ));
+        uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_and_ps(in_x, in_y));
+        if ((i & 31) == 0)
+            hits[i >> 5] = bits;
         else
-        {
-            fprintf(stderr, "Error: gettimeofday failed\n");
-            current_time = 0.0;
-        }
+            hits[i >> 5] |= bits << (i & 31);
+        found += __builtin_popcount(bits);
     }
+    return found + overlap_box_range(box, x, y, w, h, i, count, hits);
+}
 #endif
 
-    /* If first call or invalid time, initialize last_time and return 0 */
-    if (last_time == 0.0 || current_time == 0.0)
+/* Active kernels; scalar until CPU features are known */
+static ArcadeKernels kernels = {fill_span_scalar, blend_span_scalar, premultiply_span_scalar, reverse_span_scalar,
+                                rotate_quarter_scalar, sample_nearest_scalar, sample_bilinear_scalar,
+                                overlap_boxes_scalar};
+
+#ifdef ARCADE_X86_SIMD
+__attribute__((constructor)) static void select_kernels(void)
+{
+    /* Runs once before main, so no locking is needed when contexts start on threads */
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
     {
-        last_time = current_time;
-        return 0.0f;
+        kernels.fill = fill_span_avx2;
+        kernels.blend = blend_span_avx2;
+        kernels.premultiply = premultiply_span_avx2;
+        kernels.reverse = reverse_span_avx2;
+        kernels.rotate = rotate_quarter_avx2;
+        kernels.sample_nearest = sample_nearest_avx2;
+        kernels.sample_bilinear = sample_bilinear_avx2;
+        kernels.overlap_boxes = overlap_boxes_avx2;
+        return;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        kernels.fill = fill_span_sse2;
+        kernels.blend = blend_span_sse2;
+        kernels.reverse = reverse_span_sse2;
+        kernels.rotate = rotate_quarter_sse2;
+        kernels.overlap_boxes = overlap_boxes_sse2;
     }
+    if (__builtin_cpu_supports("ssse3"))
+        kernels.premultiply = premultiply_span_ssse3;
+}
+#endif
 
-    /* Calculate delta time and update last_time */
-    delta_time = (float)(current_time - last_time);
-    last_time = current_time;
+static void *alloc_pixels(size_t bytes)
+{
+    /* Aligned so full-width spans start on a vector boundary */
+#ifdef _WIN32
+    return _aligned_malloc(bytes, ARCADE_PIXEL_ALIGNMENT);
+#else
+    void *ptr = NULL;
+    return posix_memalign(&ptr, ARCADE_PIXEL_ALIGNMENT, bytes) == 0 ? ptr : NULL;
+#endif
+}
 
-    /* Clamp delta_time to avoid large jumps (e.g., during lag) */
-    if (delta_time > 0.1f)
-        delta_time = 0.1f;
-    if (delta_time < 0.0f)
-        delta_time = 0.0f;
+static void free_pixels(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
 
-    return delta_time;
+static void fill_region(ArcadeContext *ctx, int x0, int y0, int x1, int y1, uint32_t color)
+{
+    /* Pre-clipped rectangle fill; full-width regions are one contiguous span */
+    int width = ctx->state.width;
+    if (x0 == 0 && x1 == width)
+    {
+        kernels.fill(ctx->state.pixels + y0 * width, (y1 - y0) * width, color);
+        return;
+    }
+    for (int y = y0; y < y1; y++)
+        kernels.fill(ctx->state.pixels + y * width + x0, x1 - x0, color);
 }
 
 /* =========================================================================
- * Input Handling
+ * Threading
+ * Thin wrappers over Win32 / pthreads primitives for the internal worker pools.
  * ========================================================================= */
+#ifdef _WIN32
+typedef SRWLOCK ArcadeMutex;
+typedef CONDITION_VARIABLE ArcadeCond;
+typedef HANDLE ArcadeThread;
+#define ARCADE_MUTEX_INITIALIZER SRWLOCK_INIT
+#define ARCADE_COND_INITIALIZER CONDITION_VARIABLE_INIT
+#define ARCADE_THREAD_FUNC(name) static DWORD WINAPI name(LPVOID arg)
+#define ARCADE_THREAD_RETURN return 0
+#else
+typedef pthread_mutex_t ArcadeMutex;
+typedef pthread_cond_t ArcadeCond;
+typedef pthread_t ArcadeThread;
+#define ARCADE_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define ARCADE_COND_INITIALIZER PTHREAD_COND_INITIALIZER
+#define ARCADE_THREAD_FUNC(name) static void *name(void *arg)
+#define ARCADE_THREAD_RETURN return NULL
+#endif
 
-int arcade_key_pressed(unsigned int key_val)
+static void mutex_init(ArcadeMutex *m)
 {
 #ifdef _WIN32
-    int vk = arcade_to_vk(key_val);
-    return key_states[vk] ? 2 : 0;
+    InitializeSRWLock(m);
 #else
-    return key_states[key_val & 0xFF] ? 2 : 0;
+    pthread_mutex_init(m, NULL);
 #endif
 }
 
-int arcade_key_pressed_once(unsigned int key_val)
+static void mutex_destroy(ArcadeMutex *m)
 {
 #ifdef _WIN32
-    int vk = arcade_to_vk(key_val);
-    int current = key_states[vk];
-    int last = last_key_states[vk];
-    last_key_states[vk] = current;
-    return current == 1 && last == 0 ? 2 : 0;
+    (void)m; /* SRW locks hold no resources */
 #else
-    int key = key_val & 0xFF;
-    int current = key_states[key];
-    int last = last_key_states[key];
-    last_key_states[key] = current;
-    return current == 1 && last == 0 ? 2 : 0;
+    pthread_mutex_destroy(m);
 #endif
 }
 
-void arcade_clear_keys(void)
+static void mutex_lock(ArcadeMutex *m)
 {
-    memset(key_states, 0, sizeof(key_states));
-    memset(last_key_states, 0, sizeof(last_key_states));
+#ifdef _WIN32
+    AcquireSRWLockExclusive(m);
+#else
+    pthread_mutex_lock(m);
+#endif
 }
 
-/* =========================================================================
- * Sprite Management
- * ========================================================================= */
+static void mutex_unlock(ArcadeMutex *m)
+{
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(m);
+#else
+    pthread_mutex_unlock(m);
+#endif
+}
 
-static void move_sprite(ArcadeSprite *sprite, float gravity, int window_height)
+static void cond_init(ArcadeCond *c)
 {
-    if (!sprite || !sprite->active)
-        return;
-    sprite->vy += gravity;
-    sprite->y += sprite->vy;
-    sprite->x += sprite->vx;
-    if (sprite->y < 0.0f)
-    {
-        sprite->y = 0.0f;
-        sprite->vy = 0.0f;
-    }
-    if (sprite->y > window_height - sprite->height)
-    {
-        sprite->y = window_height - sprite->height;
-        sprite->vy = 0.0f;
-    }
+#ifdef _WIN32
+    InitializeConditionVariable(c);
+#else
+    pthread_cond_init(c, NULL);
+#endif
 }
 
-void arcade_move_sprite(ArcadeSprite *sprite, float gravity, int window_height)
+static void cond_destroy(ArcadeCond *c)
 {
-    if (sprite)
-        move_sprite(sprite, gravity, window_height);
+#ifdef _WIN32
+    (void)c;
+#else
+    pthread_cond_destroy(c);
+#endif
 }
 
-void arcade_move_image_sprite(ArcadeImageSprite *sprite, float gravity, int window_height)
+static void cond_wait(ArcadeCond *c, ArcadeMutex *m)
 {
-    if (!sprite || !sprite->active)
+#ifdef _WIN32
+    SleepConditionVariableSRW(c, m, INFINITE, 0);
+#else
+    pthread_cond_wait(c, m);
+#endif
+}
+
+static void cond_broadcast(ArcadeCond *c)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(c);
+#else
+    pthread_cond_broadcast(c);
+#endif
+}
+
+#ifdef _WIN32
+static int thread_start(ArcadeThread *thread, LPTHREAD_START_ROUTINE func, void *arg)
+{
+    *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+    return *thread ? 0 : 1;
+}
+#else
+static int thread_start(ArcadeThread *thread, void *(*func)(void *), void *arg)
+{
+    return pthread_create(thread, NULL, func, arg) == 0 ? 0 : 1;
+}
+#endif
+
+static void thread_join(ArcadeThread thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static int cpu_count(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static int atomic_fetch_add_int(volatile long *value, long amount)
+{
+    /* Returns the value before the addition */
+#ifdef _WIN32
+    return (int)InterlockedExchangeAdd(value, amount);
+#else
+    return (int)__atomic_fetch_add(value, amount, __ATOMIC_ACQ_REL);
+#endif
+}
+
+static int atomic_load_int(volatile long *value)
+{
+    /* Acquire: later reads see everything written before the matching store */
+#ifdef _WIN32
+    return (int)InterlockedCompareExchange(value, 0, 0);
+#else
+    return (int)__atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void atomic_store_int(volatile long *value, long new_value)
+{
+    /* Release: publishes all earlier writes to an acquiring reader */
+#ifdef _WIN32
+    InterlockedExchange(value, new_value);
+#else
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+#endif
+}
+
+/* Worker pool and per-frame bins of the tile renderer (see Tile Renderer below) */
+typedef struct ArcadeRenderPool
+{
+    ArcadeContext *ctx;          /* Context whose pixel buffer is rendered */
+    ArcadeThread *threads;       /* Worker threads; the calling thread renders as well */
+    int thread_count;            /* Number of running workers */
+    ArcadeMutex lock;            /* Guards generation, shutdown and busy */
+    ArcadeCond work_ready;       /* Signalled when a frame is published or on shutdown */
+    ArcadeCond work_done;        /* Signalled when the last worker finishes a frame */
+    int generation;              /* Incremented for every published frame */
+    int shutdown;                /* 1 = workers exit */
+    int busy;                    /* Workers still rendering the current frame */
+    volatile long next_tile;     /* Next unclaimed tile index */
+    ArcadeAnySprite *sprites;    /* Frame being rendered */
+    int *types;                  /* Types of sprites */
+    const ArcadeRegion *regions; /* Regions to repaint this frame */
+    int region_count;            /* Number of entries in regions */
+    int tiles_x, tiles_y;        /* Tile grid dimensions */
+    int *bin_start;              /* Offset of each tile's bin in bin_items (tile count + 1 entries) */
+    int *bin_items;              /* Sprite indices per tile, in painter's order */
+    int tile_capacity;           /* Allocated size of bin_start */
+    int item_capacity;           /* Allocated size of bin_items */
+} ArcadeRenderPool;
+
+static void destroy_render_pool(ArcadeContext *ctx)
+{
+    ArcadeRenderPool *pool = ctx->render_pool;
+    if (!pool)
         return;
-    sprite->vy += gravity;
-    sprite->y += sprite->vy;
-    sprite->x += sprite->vx;
-    if (sprite->y < 0.0f)
-    {
-        sprite->y = 0.0f;
-        sprite->vy = 0.0f;
-    }
-    if (sprite->y > window_height - sprite->height)
-    {
-        sprite->y = window_height - sprite->height;
-        sprite->vy = 0.0f;
-    }
+    mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    cond_broadcast(&pool->work_ready);
+    mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->thread_count; i++)
+        thread_join(pool->threads[i]);
+    cond_destroy(&pool->work_ready);
+    cond_destroy(&pool->work_done);
+    mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool->bin_start);
+    free(pool->bin_items);
+    free(pool);
+    ctx->render_pool = NULL;
 }
 
-static int check_collision(const ArcadeSprite *a, const ArcadeSprite *b)
+/* =========================================================================
+ * Core Functions
+ * ========================================================================= */
+
+ArcadeContext *arcade_context_create(void)
 {
-    if (!a || !b || !a->active || !b->active)
-        return 0;
-    return (a->x < b->x + b->width &&
-            a->x + a->width > b->x &&
-            a->y < b->y + b->height &&
-            a->y + a->height > b->y);
+    return calloc(1, sizeof(ArcadeContext));
 }
 
-int arcade_check_collision(ArcadeSprite *a, ArcadeSprite *b)
+void arcade_context_destroy(ArcadeContext *ctx)
 {
-    if (!a || !b)
-        return 0;
-    return check_collision(a, b);
+    if (!ctx || ctx == &default_context)
+        return;
+    arcade_ctx_quit(ctx);
+    free(ctx);
 }
 
-int arcade_check_image_collision(ArcadeImageSprite *a, ArcadeImageSprite *b)
+ArcadeContext *arcade_default_context(void)
 {
-    if (!a || !b || !a->active || !b->active)
-        return 0;
-    return (a->x < b->x + b->width &&
-            a->x + a->width > b->x &&
-            a->y < b->y + b->height &&
-            a->y + a->height > b->y);
+    return &default_context;
 }
 
-static int load_image_sprite(ArcadeImageSprite *sprite, const char *filename, int target_width, int target_height)
+int arcade_ctx_init(ArcadeContext *ctx, int window_width, int window_height, const char *window_title, uint32_t bg_color)
 {
-    if (!sprite || !filename)
-        return 1;
-    int width, height, channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 4);
-    if (!data)
+    /* Allow unmodified games to run on display-less machines (CI, servers) */
+    const char *headless = getenv("ARCADE_HEADLESS");
+    if (headless && headless[0] && strcmp(headless, "0") != 0)
+        return arcade_ctx_init_headless(ctx, window_width, window_height, bg_color);
+
+#ifdef _WIN32
+    /* Set up Windows-specific window class for the game window */
+    WNDCLASS wc = {0};
+    wc.lpfnWndProc = WndProc;                      /* Assign window procedure for event handling */
+    wc.hInstance = GetModuleHandle(NULL);          /* Get current application instance */
+    wc.lpszClassName = "ArcadeWindow";             /* Name of the window class */
+    wc.hCursor = LoadCursor(NULL, IDC_ARROW);      /* Use standard arrow cursor */
+    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1); /* Default window background */
+    RegisterClass(&wc);
+
+    /* Create a non-resizable window with specified dimensions */
+    DWORD style = WS_OVERLAPPEDWINDOW & ~WS_MAXIMIZEBOX & ~WS_THICKFRAME;
+    RECT rect = {0, 0, window_width, window_height};
+    AdjustWindowRect(&rect, style, FALSE); /* Adjust window size to account for borders */
+    ctx->state.hwnd = CreateWindow("ArcadeWindow", window_title, style,
+                                   CW_USEDEFAULT, CW_USEDEFAULT,
+                                   rect.right - rect.left, rect.bottom - rect.top,
+                                   NULL, NULL, wc.hInstance, ctx);
+    if (!ctx->state.hwnd)
     {
-        fprintf(stderr, "Cannot load %s\n", filename);
-        return 1;
+        fprintf(stderr, "Cannot create window\n");
+        return 1; /* Return error code on failure */
     }
-    unsigned char *resized_data = (unsigned char *)malloc(target_width * target_height * 4);
-    if (!resized_data)
+    ShowWindow(ctx->state.hwnd, SW_SHOW); /* Display the window */
+    UpdateWindow(ctx->state.hwnd);        /* Force initial window update */
+
+    ctx->state.hdc = GetDC(ctx->state.hwnd);
+    ctx->state.width = window_width;
+    ctx->state.height = window_height;
+    ctx->state.bg_color = bg_color;
+    ctx->state.running = 1;
+    ctx->full_redraw = 1;
+
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = window_width;
+    bmi.bmiHeader.biHeight = -window_height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    ctx->state.hbitmap = CreateDIBSection(ctx->state.hdc, &bmi, DIB_RGB_COLORS, (void **)&ctx->state.pixels, NULL, 0);
+    if (!ctx->state.hbitmap || !ctx->state.pixels)
     {
-        stbi_image_free(data);
+        ReleaseDC(ctx->state.hwnd, ctx->state.hdc);
+        DestroyWindow(ctx->state.hwnd);
+        fprintf(stderr, "Cannot create bitmap\n");
         return 1;
     }
-    if (stbir_resize_uint8_srgb(data, width, height, 0, resized_data, target_width, target_height, 0, 4) == 0)
+
+    fill_region(ctx, 0, 0, window_width, window_height, bg_color);
+#else
+    ctx->state.display = XOpenDisplay(NULL);
+    if (!ctx->state.display)
     {
-        fprintf(stderr, "Failed to resize %s to %dx%d\n", filename, target_width, target_height);
-        stbi_image_free(data);
-        free(resized_data);
+        fprintf(stderr, "Cannot open display\n");
         return 1;
     }
-    sprite->image_width = target_width;
-    sprite->image_height = target_height;
-    sprite->pixels = malloc(target_width * target_height * sizeof(uint32_t));
-    if (!sprite->pixels)
+
+    ctx->state.screen = DefaultScreen(ctx->state.display);
+    ctx->state.window = XCreateSimpleWindow(ctx->state.display, RootWindow(ctx->state.display, ctx->state.screen),
+                                            100, 100, window_width, window_height, 1,
+                                            BlackPixel(ctx->state.display, ctx->state.screen),
+                                            WhitePixel(ctx->state.display, ctx->state.screen));
+    XStoreName(ctx->state.display, ctx->state.window, window_title);
+    XSelectInput(ctx->state.display, ctx->state.window, ExposureMask | KeyPressMask | KeyReleaseMask | StructureNotifyMask);
+    ctx->state.wm_delete = XInternAtom(ctx->state.display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(ctx->state.display, ctx->state.window, &ctx->state.wm_delete, 1);
+    XMapWindow(ctx->state.display, ctx->state.window);
+
+    ctx->state.width = window_width;
+    ctx->state.height = window_height;
+    ctx->state.bg_color = bg_color;
+    ctx->state.running = 1;
+    ctx->full_redraw = 1;
+
+    /* Prefer a shared memory image; fall back to XPutImage if MIT-SHM is unavailable */
+    ctx->state.present_mode = ARCADE_PRESENT_BLIT;
+#ifndef ARCADE_NO_XSHM
+    if (create_shm_image(ctx, window_width, window_height) == 0)
+        ctx->state.present_mode = ARCADE_PRESENT_XSHM;
+#endif
+    if (ctx->state.present_mode == ARCADE_PRESENT_BLIT)
     {
-        stbi_image_free(data);
-        free(resized_data);
-        return 1;
+        ctx->state.pixels = alloc_pixels(window_width * window_height * sizeof(uint32_t));
+        if (!ctx->state.pixels)
+        {
+            XCloseDisplay(ctx->state.display);
+            fprintf(stderr, "Cannot allocate pixels\n");
+            return 1;
+        }
+        ctx->state.image = XCreateImage(ctx->state.display, DefaultVisual(ctx->state.display, ctx->state.screen),
+                                        DefaultDepth(ctx->state.display, ctx->state.screen), ZPixmap, 0,
+                                        (char *)ctx->state.pixels, window_width, window_height, 32, 0);
+        if (!ctx->state.image)
+        {
+            free_pixels(ctx->state.pixels);
+            XCloseDisplay(ctx->state.display);
+            fprintf(stderr, "Cannot create XImage\n");
+            return 1;
+        }
     }
-    for (int y = 0; y < target_height; y++)
+
+    ctx->state.gc = XCreateGC(ctx->state.display, ctx->state.window, 0, NULL);
+    if (!ctx->state.gc)
     {
-        for (int x = 0; x < target_width; x++)
+#ifndef ARCADE_NO_XSHM
+        if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
         {
-            int idx = (y * target_width + x) * 4;
-            sprite->pixels[y * target_width + x] =
-                (resized_data[idx] << 16) | (resized_data[idx + 1] << 8) | resized_data[idx + 2] | (resized_data[idx + 3] << 24);
+            /* Nothing was put yet, so there is no completion to wait for */
+            XShmDetach(ctx->state.display, &ctx->state.shm_info);
+            XSync(ctx->state.display, False);
+            destroy_shm_image(ctx);
         }
+        else
+#endif
+            XDestroyImage(ctx->state.image);
+        ctx->state.image = NULL;
+        ctx->state.pixels = NULL;
+        XCloseDisplay(ctx->state.display);
+        fprintf(stderr, "Cannot create GC\n");
+        return 1;
     }
-    stbi_image_free(data);
-    free(resized_data);
-    sprite->width = (float)target_width;
-    sprite->height = (float)target_height;
-    sprite->active = 1;
+
+    fill_region(ctx, 0, 0, window_width, window_height, bg_color);
+#endif
     return 0;
 }
 
-ArcadeImageSprite arcade_create_image_sprite(float x, float y, float w, float h, const char *filename)
+int arcade_init(int window_width, int window_height, const char *window_title, uint32_t bg_color)
 {
-    ArcadeImageSprite sprite = {
-        .x = x, .y = y, .width = 0.0f, .height = 0.0f, .vx = 0.0f, .vy = 0.0f, .pixels = NULL, .image_width = 0, .image_height = 0, .active = 1};
-    if (filename && load_image_sprite(&sprite, filename, (int)w, (int)h) != 0)
-    {
-        sprite.pixels = NULL;
-    }
-    return sprite;
+    return arcade_ctx_init(&default_context, window_width, window_height, window_title, bg_color);
 }
 
-void arcade_free_image_sprite(ArcadeImageSprite *sprite)
+int arcade_ctx_init_headless(ArcadeContext *ctx, int width, int height, uint32_t bg_color)
 {
-    if (sprite && sprite->pixels)
+    /* Only the pixel buffer is created; no window or display connection */
+    ctx->state.pixels = alloc_pixels(width * height * sizeof(uint32_t));
+    if (!ctx->state.pixels)
     {
-        free(sprite->pixels);
-        sprite->pixels = NULL;
-        sprite->image_width = 0;
-        sprite->image_height = 0;
-        sprite->active = 0;
+        fprintf(stderr, "Cannot allocate pixels\n");
+        return 1;
     }
+    ctx->state.width = width;
+    ctx->state.height = height;
+    ctx->state.bg_color = bg_color;
+    ctx->state.running = 1;
+    ctx->state.headless = 1;
+    ctx->full_redraw = 1;
+
+    fill_region(ctx, 0, 0, width, height, bg_color);
+    return 0;
+}
+
+int arcade_init_headless(int width, int height, uint32_t bg_color)
+{
+    return arcade_ctx_init_headless(&default_context, width, height, bg_color);
+}
+
+void arcade_ctx_quit(ArcadeContext *ctx)
+{
+    destroy_render_pool(ctx);
+    for (int i = 0; i < ARCADE_TEXT_CACHE_SIZE; i++)
+    {
+        free(ctx->text_cache[i].text);
+        free(ctx->text_cache[i].runs);
+    }
+    memset(ctx->text_cache, 0, sizeof(ctx->text_cache));
+    free(ctx->text_queue.items);
+    free(ctx->text_queue.chars);
+    free(ctx->text_shown.items);
+    free(ctx->text_shown.chars);
+    memset(&ctx->text_queue, 0, sizeof(ctx->text_queue));
+    memset(&ctx->text_shown, 0, sizeof(ctx->text_shown));
+    free(ctx->input_queue);
+    ctx->input_queue = NULL;
+    ctx->input_count = 0;
+    ctx->input_capacity = 0;
+    free(ctx->prev_sprites);
+    free(ctx->prev_types);
+    ctx->prev_sprites = NULL;
+    ctx->prev_types = NULL;
+    ctx->prev_count = 0;
+    ctx->prev_capacity = 0;
+    if (ctx->state.headless)
+    {
+        free_pixels(ctx->state.pixels);
+        ctx->state.pixels = NULL;
+        ctx->state.headless = 0;
+        return;
+    }
+#ifdef _WIN32
+    if (ctx->state.hbitmap)
+    {
+        DeleteObject(ctx->state.hbitmap);
+        ctx->state.hbitmap = NULL;
+        ctx->state.pixels = NULL;
+    }
+    if (ctx->state.hdc)
+    {
+        ReleaseDC(ctx->state.hwnd, ctx->state.hdc);
+        ctx->state.hdc = NULL;
+    }
+    if (ctx->state.hwnd)
+    {
+        DestroyWindow(ctx->state.hwnd);
+        ctx->state.hwnd = NULL;
+    }
+#else
+    if (ctx->state.image)
+    {
+#ifndef ARCADE_NO_XSHM
+        if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
+        {
+            wait_for_shm(ctx);
+            XShmDetach(ctx->state.display, &ctx->state.shm_info);
+            XSync(ctx->state.display, False);
+            destroy_shm_image(ctx);
+        }
+        else
+#endif
+            XDestroyImage(ctx->state.image);
+        ctx->state.image = NULL;
+        ctx->state.pixels = NULL;
+    }
+    if (ctx->state.gc)
+    {
+        XFreeGC(ctx->state.display, ctx->state.gc);
+        ctx->state.gc = NULL;
+    }
+    if (ctx->state.display && ctx->state.window)
+    {
+        XDestroyWindow(ctx->state.display, ctx->state.window);
+        ctx->state.window = 0;
+    }
+    if (ctx->state.display)
+    {
+        XCloseDisplay(ctx->state.display);
+        ctx->state.display = NULL;
+    }
+#endif
+}
+
+void arcade_quit(void)
+{
+    arcade_ctx_quit(&default_context);
+    arcade_audio_close();
+    arcade_set_loader_threads(0);
+}
+
+static void present_queued_text(ArcadeContext *ctx); /* Rendering: text queued without a scene render */
+
+int arcade_ctx_update(ArcadeContext *ctx)
+{
+    /* Text-only frames (pause or game-over screens) never reach a scene render;
+     * show their text here so it appears and the queue does not keep growing */
+    if (!ctx->scene_rendered && ctx->text_queue.count > 0)
+        present_queued_text(ctx);
+    ctx->scene_rendered = 0;
+    if (ctx->state.headless)
+    {
+        /* No window events; input comes only from the injected queue */
+        ctx->frame_counter++;
+        apply_input_queue(ctx);
+        return ctx->state.running;
+    }
+#ifdef _WIN32
+    MSG msg;
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+    {
+        if (msg.message == WM_QUIT)
+        {
+            ctx->state.running = 0;
+            return 0;
+        }
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+#else
+    XEvent event;
+    while (XPending(ctx->state.display))
+    {
+        XNextEvent(ctx->state.display, &event);
+        if (event.type == ClientMessage && event.xclient.data.l[0] == ctx->state.wm_delete)
+        {
+            ctx->state.running = 0;
+            return 0;
+        }
+        else if (event.type == KeyPress)
+        {
+            KeySym keysym = XLookupKeysym(&event.xkey, 0);
+            ctx->key_states[keysym & 0xFF] = 1;
+        }
+        else if (event.type == KeyRelease)
+        {
+            KeySym keysym = XLookupKeysym(&event.xkey, 0);
+            ctx->key_states[keysym & 0xFF] = 0;
+        }
+        else if (event.type == Expose)
+        {
+            ctx->full_redraw = 1; /* Window contents were lost; repaint everything next frame */
+        }
+#ifndef ARCADE_NO_XSHM
+        else if (ctx->state.present_mode == ARCADE_PRESENT_XSHM && event.type == ctx->state.shm_completion)
+        {
+            if (ctx->state.shm_pending > 0)
+                ctx->state.shm_pending--; /* Server is done reading one presented update */
+        }
+#endif
+    }
+#endif
+    ctx->frame_counter++;
+    apply_input_queue(ctx);
+    return 1;
+}
+
+int arcade_update(void)
+{
+    return arcade_ctx_update(&default_context);
+}
+
+int arcade_ctx_inject_key(ArcadeContext *ctx, unsigned int key_val, int pressed, int frame)
+{
+    if (ctx->input_count == ctx->input_capacity)
+    {
+        int new_capacity = ctx->input_capacity ? ctx->input_capacity * 2 : 64;
+        ArcadeInputEvent *grown = realloc(ctx->input_queue, new_capacity * sizeof(ArcadeInputEvent));
+        if (!grown)
+            return 1;
+        ctx->input_queue = grown;
+        ctx->input_capacity = new_capacity;
+    }
+    ctx->input_queue[ctx->input_count].key_val = key_val;
+    ctx->input_queue[ctx->input_count].pressed = pressed;
+    ctx->input_queue[ctx->input_count].frame = frame;
+    ctx->input_count++;
+    return 0;
+}
+
+int arcade_inject_key(unsigned int key_val, int pressed, int frame)
+{
+    return arcade_ctx_inject_key(&default_context, key_val, pressed, frame);
+}
+
+int arcade_ctx_frame_count(ArcadeContext *ctx)
+{
+    return ctx->frame_counter;
+}
+
+int arcade_frame_count(void)
+{
+    return arcade_ctx_frame_count(&default_context);
+}
+
+int arcade_ctx_running(ArcadeContext *ctx)
+{
+    return ctx->state.running;
+}
+
+int arcade_running(void)
+{
+    return arcade_ctx_running(&default_context);
+}
+
+void arcade_ctx_set_running(ArcadeContext *ctx, int value)
+{
+    ctx->state.running = value;
+}
+
+void arcade_set_running(int value)
+{
+    arcade_ctx_set_running(&default_context, value);
+}
+
+void arcade_sleep(unsigned int milliseconds)
+{
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    usleep(milliseconds * 1000); /* Convert ms to microseconds */
+#endif
+}
+
+float arcade_ctx_delta_time(ArcadeContext *ctx)
+{
+    double current_time = 0.0; /* Current frame time */
+    float delta_time;
+
+#ifdef _WIN32
+    /* Use high-resolution performance counter for precise timing on Windows */
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency); /* Get ticks per second */
+    QueryPerformanceCounter(&counter);     /* Get current tick count */
+    current_time = (double)counter.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    int clock_result = -1;
+#ifdef CLOCK_MONOTONIC
+    /* Prefer CLOCK_MONOTONIC for consistent timing (not affected by system clock changes) */
+    clock_result = clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (clock_result == 0)
+    {
+        current_time = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+    }
+#else
+#ifdef CLOCK_REALTIME
+    /* Fallback to CLOCK_REALTIME (less reliable due to system clock adjustments) */
+    clock_result = clock_gettime(CLOCK_REALTIME, &ts);
+    if (clock_result == 0)
+    {
+        current_time = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+        fprintf(stderr, "Warning: Using CLOCK_REALTIME (less reliable for timing)\n");
+    }
+#else
+    /* Fallback to gettimeofday if no POSIX clocks are available */
+    fprintf(stderr, "Warning: No POSIX clocks available, falling back to gettimeofday\n");
+    struct timeval tv;
+    if (gettimeofday(&tv, NULL) == 0)
+    {
+        current_time = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+    }
+    else
+    {
+        fprintf(stderr, "Error: gettimeofday failed\n");
+        current_time = 0.0;
+    }
+#endif
+#endif
+    if (clock_result != 0 && current_time == 0.0)
+    {
+        fprintf(stderr, "Warning: clock_gettime failed, falling back to gettimeofday\n");
+        struct timeval tv;
+        if (gettimeofday(&tv, NULL) == 0)
+        {
+            current_time = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+        }
+        else
+        {
+            fprintf(stderr, "Error: gettimeofday failed\n");
+            current_time = 0.0;
+        }
+    }
+#endif
+
+    /* If first call or invalid time, initialize last_time and return 0 */
+    if (ctx->last_time == 0.0 || current_time == 0.0)
+    {
+        ctx->last_time = current_time;
+        return 0.0f;
+    }
+
+    /* Calculate delta time and update last_time */
+    delta_time = (float)(current_time - ctx->last_time);
+    ctx->last_time = current_time;
+
+    /* Clamp delta_time to avoid large jumps (e.g., during lag) */
+    if (delta_time > 0.1f)
+        delta_time = 0.1f;
+    if (delta_time < 0.0f)
+        delta_time = 0.0f;
+
+    return delta_time;
+}
+
+float arcade_delta_time(void)
+{
+    return arcade_ctx_delta_time(&default_context);
+}
+
+/* =========================================================================
+ * Input Handling
+ * ========================================================================= */
+
+int arcade_ctx_key_pressed(ArcadeContext *ctx, unsigned int key_val)
+{
+    return ctx->key_states[key_index(key_val)] ? 2 : 0;
+}
+
+int arcade_key_pressed(unsigned int key_val)
+{
+    return arcade_ctx_key_pressed(&default_context, key_val);
+}
+
+int arcade_ctx_key_pressed_once(ArcadeContext *ctx, unsigned int key_val)
+{
+    int key = key_index(key_val);
+    int current = ctx->key_states[key];
+    int last = ctx->last_key_states[key];
+    ctx->last_key_states[key] = current;
+    return current == 1 && last == 0 ? 2 : 0;
+}
+
+int arcade_key_pressed_once(unsigned int key_val)
+{
+    return arcade_ctx_key_pressed_once(&default_context, key_val);
+}
+
+void arcade_ctx_clear_keys(ArcadeContext *ctx)
+{
+    memset(ctx->key_states, 0, sizeof(ctx->key_states));
+    memset(ctx->last_key_states, 0, sizeof(ctx->last_key_states));
+}
+
+void arcade_clear_keys(void)
+{
+    arcade_ctx_clear_keys(&default_context);
+}
+
+/* =========================================================================
+ * Image Asset Cache
+ * Decoded images are shared by every sprite loaded from the same file at the
+ * same size. Each sprite holds one reference; the pixels are freed when the
+ * last sprite is released.
+ * ========================================================================= */
+#define ARCADE_ASSET_BUCKETS 256 /* Hash buckets of the asset cache */
+#define ARCADE_MASK_ALPHA 128    /* Pixels at least this opaque are solid for pixel collisions */
+
+/* One bit per pixel of an image: set where alpha >= ARCADE_MASK_ALPHA */
+typedef struct ArcadeCollisionMask
+{
+    const uint32_t *pixels;           /* First pixel of the image the mask describes */
+    int width, height;                /* Image size (pixels) */
+    int words;                        /* 64-bit words per row */
+    struct ArcadeCollisionMask *next; /* Next mask of the same asset */
+    uint64_t bits[];                  /* Rows of words; bit x % 64 of word x / 64 is pixel x */
+} ArcadeCollisionMask;
+
+static ArcadeCollisionMask *build_collision_mask(const uint32_t *pixels, int width, int height, int stride)
+{
+    int words = (width + 63) / 64;
+    ArcadeCollisionMask *mask = malloc(sizeof(ArcadeCollisionMask) + (size_t)words * height * sizeof(uint64_t));
+    if (!mask)
+        return NULL;
+    mask->pixels = pixels;
+    mask->width = width;
+    mask->height = height;
+    mask->words = words;
+    mask->next = NULL;
+    for (int y = 0; y < height; y++)
+    {
+        const uint32_t *row = pixels + (size_t)y * stride;
+        uint64_t *out = mask->bits + (size_t)y * words;
+        for (int w = 0; w < words; w++)
+        {
+            uint64_t word = 0;
+            int end = width - w * 64 < 64 ? width - w * 64 : 64;
+            for (int b = 0; b < end; b++)
+                word |= (uint64_t)((row[w * 64 + b] >> 24) >= ARCADE_MASK_ALPHA) << b;
+            out[w] = word;
+        }
+    }
+    return mask;
+}
+
+static size_t collision_mask_bytes(const ArcadeCollisionMask *mask)
+{
+    return sizeof(ArcadeCollisionMask) + (size_t)mask->words * mask->height * sizeof(uint64_t);
+}
+
+struct ArcadeImageAsset
+{
+    char *path;                    /* Source file (NULL for atlas pages) */
+    int width, height;             /* Size the image was resized to */
+    uint32_t *pixels;              /* Shared, immutable premultiplied ARGB pixels */
+    uint8_t *opaque_rows;          /* Per-row opacity flags (may be NULL) */
+    size_t bytes;                  /* Memory held by pixels and opaque_rows */
+    void *mapping;                 /* Mapped asset pack the sprites point into, or NULL */
+    size_t mapping_bytes;          /* Size of mapping */
+    uint32_t hash;                 /* Hash of (path, width, height) */
+    long refs;                     /* Sprites referencing this asset (guarded by the cache lock) */
+    ArcadeCollisionMask *masks;    /* Pixel collision masks of images in this asset (guarded by the cache lock) */
+    struct ArcadeImageAsset *next; /* Next asset in the same bucket */
+};
+
+static struct
+{
+    ArcadeMutex lock;                                /* Guards everything below and asset refs */
+    ArcadeImageAsset *buckets[ARCADE_ASSET_BUCKETS]; /* Live assets by hash */
+    ArcadeAssetStats stats;                          /* Counters reported by arcade_asset_stats */
+} asset_cache = {.lock = ARCADE_MUTEX_INITIALIZER};
+
+static uint32_t hash_asset_key(const char *path, int width, int height)
+{
+    /* FNV-1a over the path, then the size */
+    uint32_t hash = 2166136261u;
+    for (; *path; path++)
+        hash = (hash ^ (unsigned char)*path) * 16777619u;
+    hash = (hash ^ (uint32_t)width) * 16777619u;
+    return (hash ^ (uint32_t)height) * 16777619u;
+}
+
+static ArcadeImageAsset *find_asset_locked(const char *path, int width, int height, uint32_t hash)
+{
+    for (ArcadeImageAsset *asset = asset_cache.buckets[hash % ARCADE_ASSET_BUCKETS]; asset; asset = asset->next)
+        if (asset->hash == hash && asset->width == width && asset->height == height && strcmp(asset->path, path) == 0)
+            return asset;
+    return NULL;
+}
+
+static void *map_file(const char *path, size_t *size)
+{
+    /* Private copy-on-write mapping: clean pages are shared with other processes */
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+    void *view = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0 && (ULONGLONG)file_size.QuadPart <= (SIZE_T)-1)
+        mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (mapping)
+    {
+        view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        CloseHandle(mapping); /* The view keeps the mapping alive */
+    }
+    CloseHandle(file);
+    *size = view ? (size_t)file_size.QuadPart : 0;
+    return view;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    struct stat info;
+    void *base = NULL;
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        base = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED)
+            base = NULL;
+    }
+    close(fd); /* The mapping stays valid */
+    *size = base ? (size_t)info.st_size : 0;
+    return base;
+#endif
+}
+
+static void unmap_file(void *base, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(base);
+#else
+    munmap(base, size);
+#endif
+}
+
+static void free_asset(ArcadeImageAsset *asset)
+{
+    if (asset->mapping)
+        unmap_file(asset->mapping, asset->mapping_bytes);
+    free_pixels(asset->pixels);
+    free(asset->opaque_rows);
+    free(asset->path);
+    while (asset->masks)
+    {
+        ArcadeCollisionMask *next = asset->masks->next;
+        free(asset->masks);
+        asset->masks = next;
+    }
+    free(asset);
+}
+
+static ArcadeImageAsset *decode_image_asset(const char *filename, int target_width, int target_height)
+{
+    if (target_width <= 0 || target_height <= 0)
+    {
+        fprintf(stderr, "Invalid size %dx%d for %s\n", target_width, target_height, filename);
+        return NULL;
+    }
+    int width, height, channels;
+    unsigned char *data = stbi_load(filename, &width, &height, &channels, 4);
+    if (!data)
+    {
+        fprintf(stderr, "Cannot load %s\n", filename);
+        return NULL;
+    }
+    ArcadeImageAsset *asset = calloc(1, sizeof(ArcadeImageAsset));
+    if (asset)
+    {
+        asset->path = malloc(strlen(filename) + 1);
+        asset->pixels = alloc_pixels(target_width * target_height * sizeof(uint32_t));
+    }
+    if (!asset || !asset->path || !asset->pixels)
+    {
+        if (asset)
+            free_asset(asset);
+        stbi_image_free(data);
+        return NULL;
+    }
+    strcpy(asset->path, filename);
+    asset->width = target_width;
+    asset->height = target_height;
+    /* Resize straight into the final buffer (RGBA bytes there until converted
+     * below); images already at the target size skip the resampler */
+    const unsigned char *rgba = data;
+    if (width != target_width || height != target_height)
+    {
+        if (stbir_resize_uint8_srgb(data, width, height, 0, (unsigned char *)asset->pixels, target_width, target_height, 0, 4) == 0)
+        {
+            fprintf(stderr, "Failed to resize %s to %dx%d\n", filename, target_width, target_height);
+            stbi_image_free(data);
+            free_asset(asset);
+            return NULL;
+        }
+        rgba = (const unsigned char *)asset->pixels;
+    }
+    /* Optional: without it every row is blended, which is correct but slower */
+    asset->opaque_rows = malloc(target_height);
+    asset->bytes = target_width * target_height * sizeof(uint32_t) + (asset->opaque_rows ? target_height : 0);
+    /* Convert RGBA bytes to premultiplied ARGB once (in place after a resize),
+     * so drawing is a single multiply-add */
+    for (int y = 0; y < target_height; y++)
+    {
+        uint32_t row_alpha = kernels.premultiply(asset->pixels + y * target_width, rgba + (size_t)y * target_width * 4, target_width);
+        if (asset->opaque_rows)
+            asset->opaque_rows[y] = row_alpha == 255;
+    }
+    /* Collision mask now, while the pixels are hot; optional like opaque_rows */
+    asset->masks = build_collision_mask(asset->pixels, target_width, target_height, target_width);
+    if (asset->masks)
+        asset->bytes += collision_mask_bytes(asset->masks);
+    stbi_image_free(data);
+    return asset;
+}
+
+static ArcadeImageAsset *acquire_image_asset(const char *filename, int width, int height)
+{
+    /* Returns a new reference to the cached image, decoding it on a miss */
+    uint32_t hash = hash_asset_key(filename, width, height);
+    mutex_lock(&asset_cache.lock);
+    ArcadeImageAsset *asset = find_asset_locked(filename, width, height, hash);
+    if (asset)
+    {
+        asset->refs++;
+        asset_cache.stats.hits++;
+        mutex_unlock(&asset_cache.lock);
+        return asset;
+    }
+    asset_cache.stats.misses++;
+    mutex_unlock(&asset_cache.lock);
+
+    /* Decode without the lock so loads of different files can overlap */
+    ArcadeImageAsset *loaded = decode_image_asset(filename, width, height);
+    if (!loaded)
+        return NULL;
+    loaded->hash = hash;
+    loaded->refs = 1;
+    mutex_lock(&asset_cache.lock);
+    asset = find_asset_locked(filename, width, height, hash);
+    if (asset)
+        asset->refs++; /* Another thread loaded it meanwhile; keep theirs */
+    else
+    {
+        ArcadeImageAsset **bucket = &asset_cache.buckets[hash % ARCADE_ASSET_BUCKETS];
+        loaded->next = *bucket;
+        *bucket = loaded;
+        asset_cache.stats.assets++;
+        asset_cache.stats.bytes_resident += loaded->bytes;
+    }
+    mutex_unlock(&asset_cache.lock);
+    if (asset)
+    {
+        free_asset(loaded);
+        return asset;
+    }
+    return loaded;
+}
+
+static void retain_image_asset(ArcadeImageAsset *asset)
+{
+    mutex_lock(&asset_cache.lock);
+    asset->refs++;
+    mutex_unlock(&asset_cache.lock);
+}
+
+static void release_image_asset(ArcadeImageAsset *asset)
+{
+    mutex_lock(&asset_cache.lock);
+    if (--asset->refs > 0)
+    {
+        mutex_unlock(&asset_cache.lock);
+        return;
+    }
+    if (asset->path)
+    {
+        /* Atlas pages have no path and are not in the lookup table */
+        ArcadeImageAsset **link = &asset_cache.buckets[asset->hash % ARCADE_ASSET_BUCKETS];
+        while (*link != asset)
+            link = &(*link)->next;
+        *link = asset->next;
+    }
+    asset_cache.stats.assets--;
+    asset_cache.stats.bytes_resident -= asset->bytes;
+    mutex_unlock(&asset_cache.lock);
+    free_asset(asset);
+}
+
+static void register_asset(ArcadeImageAsset *asset)
+{
+    /* Counts an asset that is not in the lookup table (atlas pages, packs) */
+    mutex_lock(&asset_cache.lock);
+    asset_cache.stats.assets++;
+    asset_cache.stats.bytes_resident += asset->bytes;
+    mutex_unlock(&asset_cache.lock);
+}
+
+static void update_opaque_rows(ArcadeImageAsset *asset)
+{
+    for (int y = 0; y < asset->height; y++)
+    {
+        const uint32_t *row = asset->pixels + (size_t)y * asset->width;
+        uint32_t alpha = 0xFF000000;
+        for (int x = 0; x < asset->width; x++)
+            alpha &= row[x];
+        asset->opaque_rows[y] = (alpha & 0xFF000000) == 0xFF000000;
+    }
+}
+
+static ArcadeImageAsset *create_pixel_asset(int width, int height)
+{
+    /* Uncached, counted asset for pixels generated at run time; one reference */
+    ArcadeImageAsset *asset = calloc(1, sizeof(ArcadeImageAsset));
+    if (asset)
+    {
+        asset->pixels = alloc_pixels((size_t)width * height * sizeof(uint32_t));
+        asset->opaque_rows = malloc(height);
+    }
+    if (!asset || !asset->pixels || !asset->opaque_rows)
+    {
+        if (asset)
+            free_asset(asset);
+        return NULL;
+    }
+    asset->width = width;
+    asset->height = height;
+    asset->bytes = (size_t)width * height * sizeof(uint32_t) + height;
+    asset->refs = 1;
+    register_asset(asset);
+    return asset;
+}
+
+ArcadeAssetStats arcade_asset_stats(void)
+{
+    mutex_lock(&asset_cache.lock);
+    ArcadeAssetStats stats = asset_cache.stats;
+    mutex_unlock(&asset_cache.lock);
+    return stats;
+}
+
+/* =========================================================================
+ * Texture Atlas
+ * Packs many images into a few large pages with a skyline (bottom-left)
+ * packer. Pages are image assets, so atlas sprites are retained and released
+ * like any other image sprite and a page lives until its last sprite is gone.
+ * ========================================================================= */
+#define ARCADE_ATLAS_ALIGN 4 /* Sub-image x positions are multiples of this many pixels (16 bytes) */
+
+typedef struct
+{
+    char *path;            /* Source file */
+    int width, height;     /* Size the image is resized to */
+    int page;              /* Page index, -1 until built */
+    int x, y;              /* Top-left corner inside the page */
+    int row_offset;        /* First entry of this image in the page's opaque_rows */
+    ArcadeImageAsset *img; /* Decoded image, only during arcade_build_atlas */
+} ArcadeAtlasEntry;
+
+typedef struct
+{
+    int x, y, width; /* Top edge of the packed area from x to x + width */
+} ArcadeSkylineNode;
+
+typedef struct
+{
+    ArcadeSkylineNode *nodes; /* Skyline, left to right */
+    int node_count;
+    int used_height;          /* Bottom of the lowest placed image */
+    int row_count;            /* Opaque row flags handed out so far */
+} ArcadeAtlasPacker;
+
+struct ArcadeAtlas
+{
+    int page_width, page_height; /* Maximum page size */
+    ArcadeAtlasEntry *entries;   /* Images in the order they were added */
+    int entry_count, entry_capacity;
+    ArcadeImageAsset **pages;    /* Built pages, one reference each */
+    int page_count;
+};
+
+static int skyline_fit(const ArcadeAtlasPacker *packer, int index, int width, int height, int page_width, int page_height)
+{
+    /* Y at which a width x height box rests on the skyline starting at node index, or -1 */
+    int x = packer->nodes[index].x;
+    if (x + width > page_width)
+        return -1;
+    int y = 0;
+    for (int i = index, remaining = width; remaining > 0; i++)
+    {
+        if (packer->nodes[i].y > y)
+            y = packer->nodes[i].y;
+        remaining -= packer->nodes[i].width;
+    }
+    return y + height <= page_height ? y : -1;
+}
+
+static int skyline_find(const ArcadeAtlasPacker *packer, int width, int height, int page_width, int page_height,
+                        int *best_x, int *best_y)
+{
+    /* Lowest position first, leftmost on ties; returns the node index or -1 */
+    int best = -1;
+    for (int i = 0; i < packer->node_count; i++)
+    {
+        int y = skyline_fit(packer, i, width, height, page_width, page_height);
+        if (y >= 0 && (best < 0 || y < *best_y))
+        {
+            best = i;
+            *best_x = packer->nodes[i].x;
+            *best_y = y;
+        }
+    }
+    return best;
+}
+
+static void skyline_place(ArcadeAtlasPacker *packer, int index, int x, int top, int width)
+{
+    /* Raise the skyline over [x, x + width) to top; the node array has room for every split */
+    ArcadeSkylineNode placed = {x, top, width};
+    int end = index;
+    while (end < packer->node_count && packer->nodes[end].x + packer->nodes[end].width <= x + width)
+        end++;
+    if (end < packer->node_count && packer->nodes[end].x < x + width)
+    {
+        /* Keep the uncovered right part of a partially covered node */
+        int cut = x + width - packer->nodes[end].x;
+        packer->nodes[end].x += cut;
+        packer->nodes[end].width -= cut;
+    }
+    memmove(&packer->nodes[index + 1], &packer->nodes[end], (packer->node_count - end) * sizeof(ArcadeSkylineNode));
+    packer->node_count -= end - index - 1;
+    packer->nodes[index] = placed;
+    /* Merge neighbours at the same height so the skyline stays short */
+    for (int i = 0; i + 1 < packer->node_count;)
+    {
+        if (packer->nodes[i].y == packer->nodes[i + 1].y)
+        {
+            packer->nodes[i].width += packer->nodes[i + 1].width;
+            memmove(&packer->nodes[i + 1], &packer->nodes[i + 2], (packer->node_count - i - 2) * sizeof(ArcadeSkylineNode));
+            packer->node_count--;
+        }
+        else
+            i++;
+    }
+}
+
+static int compare_atlas_entries(const void *a, const void *b)
+{
+    /* Tallest first, then widest: the usual order for skyline packing */
+    const ArcadeAtlasEntry *p = *(const ArcadeAtlasEntry *const *)a;
+    const ArcadeAtlasEntry *q = *(const ArcadeAtlasEntry *const *)b;
+    if (p->height != q->height)
+        return q->height - p->height;
+    return q->width - p->width;
+}
+
+static void release_atlas_pages(ArcadeAtlas *atlas)
+{
+    for (int i = 0; i < atlas->page_count; i++)
+        release_image_asset(atlas->pages[i]);
+    free(atlas->pages);
+    atlas->pages = NULL;
+    atlas->page_count = 0;
+}
+
+ArcadeAtlas *arcade_create_atlas(int page_width, int page_height)
+{
+    if (page_width < ARCADE_ATLAS_ALIGN || page_height <= 0)
+    {
+        fprintf(stderr, "Invalid atlas page size %dx%d\n", page_width, page_height);
+        return NULL;
+    }
+    ArcadeAtlas *atlas = calloc(1, sizeof(ArcadeAtlas));
+    if (!atlas)
+        return NULL;
+    /* Whole vector-aligned rows: every page row starts on an ARCADE_PIXEL_ALIGNMENT boundary */
+    int align = ARCADE_PIXEL_ALIGNMENT / sizeof(uint32_t);
+    atlas->page_width = (page_width + align - 1) / align * align;
+    atlas->page_height = page_height;
+    return atlas;
+}
+
+int arcade_atlas_add_image(ArcadeAtlas *atlas, const char *filename, int w, int h)
+{
+    if (!atlas || !filename || w <= 0 || h <= 0)
+        return -1;
+    if (w > atlas->page_width || h > atlas->page_height)
+    {
+        fprintf(stderr, "Image %s (%dx%d) does not fit an atlas page of %dx%d\n", filename, w, h,
+                atlas->page_width, atlas->page_height);
+        return -1;
+    }
+    if (atlas->entry_count == atlas->entry_capacity)
+    {
+        int capacity = atlas->entry_capacity ? atlas->entry_capacity * 2 : 16;
+        ArcadeAtlasEntry *entries = realloc(atlas->entries, capacity * sizeof(ArcadeAtlasEntry));
+        if (!entries)
+            return -1;
+        atlas->entries = entries;
+        atlas->entry_capacity = capacity;
+    }
+    ArcadeAtlasEntry *entry = &atlas->entries[atlas->entry_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->path = malloc(strlen(filename) + 1);
+    if (!entry->path)
+        return -1;
+    strcpy(entry->path, filename);
+    entry->width = w;
+    entry->height = h;
+    entry->page = -1;
+    return atlas->entry_count++;
+}
+
+int arcade_build_atlas(ArcadeAtlas *atlas)
+{
+    if (!atlas || atlas->entry_count == 0)
+        return 1;
+    release_atlas_pages(atlas);
+    int count = atlas->entry_count;
+    ArcadeAtlasEntry **order = malloc(count * sizeof(ArcadeAtlasEntry *));
+    ArcadeAtlasPacker *packers = calloc(count, sizeof(ArcadeAtlasPacker)); /* At most one page per image */
+    int status = order && packers ? 0 : 1;
+
+    /* Decode everything first; the temporary images are freed once copied into pages */
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        ArcadeAtlasEntry *entry = &atlas->entries[i];
+        entry->img = decode_image_asset(entry->path, entry->width, entry->height);
+        if (!entry->img)
+            status = 1;
+        order[i] = entry;
+    }
+
+    /* Pack, opening a new page when no existing one has room */
+    int page_count = 0;
+    if (status == 0)
+        qsort(order, count, sizeof(ArcadeAtlasEntry *), compare_atlas_entries);
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        ArcadeAtlasEntry *entry = order[i];
+        /* Page width is a multiple of ARCADE_ATLAS_ALIGN, so the padded width still fits */
+        int padded = (entry->width + ARCADE_ATLAS_ALIGN - 1) / ARCADE_ATLAS_ALIGN * ARCADE_ATLAS_ALIGN;
+        int x = 0, y = 0, node = -1, page = -1;
+        for (int p = 0; p < page_count && node < 0; p++)
+        {
+            node = skyline_find(&packers[p], padded, entry->height, atlas->page_width, atlas->page_height, &x, &y);
+            page = p;
+        }
+        if (node < 0)
+        {
+            /* Aligned node widths bound the skyline to page_width / ARCADE_ATLAS_ALIGN nodes */
+            page = page_count++;
+            packers[page].nodes = malloc((atlas->page_width / ARCADE_ATLAS_ALIGN + 1) * sizeof(ArcadeSkylineNode));
+            if (!packers[page].nodes)
+            {
+                status = 1;
+                break;
+            }
+            packers[page].nodes[0] = (ArcadeSkylineNode){0, 0, atlas->page_width};
+            packers[page].node_count = 1;
+            node = 0;
+            x = y = 0;
+        }
+        ArcadeAtlasPacker *packer = &packers[page];
+        skyline_place(packer, node, x, y + entry->height, padded);
+        if (y + entry->height > packer->used_height)
+            packer->used_height = y + entry->height;
+        entry->page = page;
+        entry->x = x;
+        entry->y = y;
+        entry->row_offset = packer->row_count;
+        packer->row_count += entry->height;
+    }
+
+    /* One pixel allocation per page, trimmed to the rows actually used */
+    if (status == 0)
+    {
+        atlas->pages = calloc(page_count, sizeof(ArcadeImageAsset *));
+        status = atlas->pages ? 0 : 1;
+    }
+    for (int p = 0; p < page_count && status == 0; p++)
+    {
+        ArcadeImageAsset *page = calloc(1, sizeof(ArcadeImageAsset));
+        size_t pixel_bytes = (size_t)atlas->page_width * packers[p].used_height * sizeof(uint32_t);
+        if (page)
+        {
+            page->pixels = alloc_pixels(pixel_bytes);
+            page->opaque_rows = malloc(packers[p].row_count);
+        }
+        if (!page || !page->pixels || !page->opaque_rows)
+        {
+            if (page)
+                free_asset(page);
+            status = 1;
+            break;
+        }
+        memset(page->pixels, 0, pixel_bytes);
+        page->width = atlas->page_width;
+        page->height = packers[p].used_height;
+        page->bytes = pixel_bytes + packers[p].row_count;
+        page->refs = 1;
+        atlas->pages[atlas->page_count++] = page;
+        register_asset(page);
+    }
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        ArcadeAtlasEntry *entry = &atlas->entries[i];
+        ArcadeImageAsset *page = atlas->pages[entry->page];
+        for (int y = 0; y < entry->height; y++)
+            memcpy(page->pixels + (size_t)(entry->y + y) * page->width + entry->x,
+                   entry->img->pixels + (size_t)y * entry->width, entry->width * sizeof(uint32_t));
+        if (entry->img->opaque_rows)
+            memcpy(page->opaque_rows + entry->row_offset, entry->img->opaque_rows, entry->height);
+        else
+            memset(page->opaque_rows + entry->row_offset, 0, entry->height);
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        if (atlas->entries[i].img)
+            free_asset(atlas->entries[i].img);
+        atlas->entries[i].img = NULL;
+    }
+    if (packers)
+        for (int p = 0; p < count; p++)
+            free(packers[p].nodes);
+    free(packers);
+    free(order);
+    if (status != 0)
+    {
+        fprintf(stderr, "Failed to build texture atlas\n");
+        release_atlas_pages(atlas);
+    }
+    return status;
+}
+
+int arcade_atlas_page_count(const ArcadeAtlas *atlas)
+{
+    return atlas ? atlas->page_count : 0;
+}
+
+ArcadeImageSprite arcade_create_atlas_sprite(ArcadeAtlas *atlas, int index, float x, float y)
+{
+    ArcadeImageSprite sprite = {.x = x, .y = y};
+    if (!atlas || index < 0 || index >= atlas->entry_count || atlas->entries[index].page < 0 ||
+        atlas->entries[index].page >= atlas->page_count)
+    {
+        fprintf(stderr, "Atlas image %d is not built\n", index);
+        return sprite;
+    }
+    const ArcadeAtlasEntry *entry = &atlas->entries[index];
+    ArcadeImageAsset *page = atlas->pages[entry->page];
+    retain_image_asset(page);
+    sprite.asset = page;
+    sprite.pixels = page->pixels + (size_t)entry->y * page->width + entry->x;
+    sprite.stride = page->width;
+    sprite.opaque_rows = page->opaque_rows + entry->row_offset;
+    sprite.image_width = entry->width;
+    sprite.image_height = entry->height;
+    sprite.width = (float)entry->width;
+    sprite.height = (float)entry->height;
+    sprite.active = 1;
+    return sprite;
+}
+
+void arcade_free_atlas(ArcadeAtlas *atlas)
+{
+    if (!atlas)
+        return;
+    release_atlas_pages(atlas);
+    for (int i = 0; i < atlas->entry_count; i++)
+        free(atlas->entries[i].path);
+    free(atlas->entries);
+    free(atlas);
+}
+
+/* =========================================================================
+ * Asset Packs
+ * A pack holds images that were already decoded, resized and premultiplied
+ * by arcade_write_pack (or the arcade_pack tool). Opening one maps the file
+ * and points sprites straight at its pixels, so nothing is decoded at run
+ * time and every process using the pack shares the same pages.
+ *
+ * Layout (native byte order, offsets from the start of the file):
+ *   ArcadePackHeader
+ *   ArcadePackEntry[entry_count], sorted by name
+ *   names: NUL-terminated strings
+ *   per entry, 64-byte aligned: width * height ARGB pixels, then height opaque-row flags
+ * ========================================================================= */
+#define ARCADE_PACK_MAGIC "ARCPACK"     /* 8 bytes including the terminator */
+#define ARCADE_PACK_VERSION 1           /* Bumped on incompatible layout changes */
+#define ARCADE_PACK_MAX_DIMENSION 16384 /* Largest accepted image edge (pixels) */
+
+typedef struct
+{
+    char magic[8];         /* ARCADE_PACK_MAGIC */
+    uint32_t version;      /* ARCADE_PACK_VERSION */
+    uint32_t entry_count;  /* Number of images */
+    uint32_t names_offset; /* Start of the name strings */
+    uint32_t names_size;   /* Bytes of name strings */
+} ArcadePackHeader;
+
+typedef struct
+{
+    uint32_t name_offset;   /* Name, relative to names_offset */
+    uint32_t width, height; /* Image size (pixels) */
+    uint32_t reserved;      /* Zero */
+    uint64_t pixel_offset;  /* Premultiplied ARGB pixels, 64-byte aligned */
+    uint64_t opaque_offset; /* One opacity flag per row */
+} ArcadePackEntry;
+
+struct ArcadePack
+{
+    ArcadeImageAsset *asset;        /* Owns the mapping; referenced by the pack and its sprites */
+    const unsigned char *base;      /* Mapped file */
+    const ArcadePackEntry *entries; /* Index, sorted by name */
+    uint32_t entry_count;           /* Number of entries */
+    const char *names;              /* Name strings */
+};
+
+typedef struct
+{
+    const char *name;  /* File the image is loaded from, and its name in the pack */
+    int width, height; /* Size to store */
+} ArcadePackSource;
+
+static int compare_pack_sources(const void *a, const void *b)
+{
+    return strcmp(((const ArcadePackSource *)a)->name, ((const ArcadePackSource *)b)->name);
+}
+
+static uint64_t align_pack_offset(uint64_t offset)
+{
+    return (offset + ARCADE_PIXEL_ALIGNMENT - 1) / ARCADE_PIXEL_ALIGNMENT * ARCADE_PIXEL_ALIGNMENT;
+}
+
+int arcade_write_pack(const char *pack_path, const char **filenames, const int *widths, const int *heights, int count)
+{
+    if (!pack_path || !filenames || !widths || !heights || count <= 0)
+        return 1;
+    ArcadePackSource *sources = malloc(count * sizeof(ArcadePackSource));
+    ArcadePackEntry *entries = calloc(count, sizeof(ArcadePackEntry));
+    if (!sources || !entries)
+    {
+        free(sources);
+        free(entries);
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+        sources[i] = (ArcadePackSource){filenames[i], widths[i], heights[i]};
+    qsort(sources, count, sizeof(ArcadePackSource), compare_pack_sources);
+
+    /* Lay the file out first, so images can be decoded and written one at a time */
+    ArcadePackHeader header = {ARCADE_PACK_MAGIC, ARCADE_PACK_VERSION, (uint32_t)count, 0, 0};
+    header.names_offset = sizeof(ArcadePackHeader) + count * sizeof(ArcadePackEntry);
+    int status = 0;
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        if (i > 0 && strcmp(sources[i - 1].name, sources[i].name) == 0)
+        {
+            fprintf(stderr, "%s is listed twice in pack %s\n", sources[i].name, pack_path);
+            status = 1;
+        }
+        else if (sources[i].width <= 0 || sources[i].height <= 0 || sources[i].width > ARCADE_PACK_MAX_DIMENSION ||
+                 sources[i].height > ARCADE_PACK_MAX_DIMENSION)
+        {
+            fprintf(stderr, "Invalid size %dx%d for %s\n", sources[i].width, sources[i].height, sources[i].name);
+            status = 1;
+        }
+        entries[i].name_offset = header.names_size;
+        entries[i].width = sources[i].width;
+        entries[i].height = sources[i].height;
+        header.names_size += strlen(sources[i].name) + 1;
+    }
+    uint64_t offset = (uint64_t)header.names_offset + header.names_size;
+    for (int i = 0; i < count; i++)
+    {
+        entries[i].pixel_offset = align_pack_offset(offset);
+        entries[i].opaque_offset = entries[i].pixel_offset + (uint64_t)entries[i].width * entries[i].height * sizeof(uint32_t);
+        offset = entries[i].opaque_offset + entries[i].height;
+    }
+
+    FILE *file = status == 0 ? fopen(pack_path, "wb") : NULL;
+    if (status == 0 && !file)
+    {
+        fprintf(stderr, "Cannot create pack %s\n", pack_path);
+        status = 1;
+    }
+    if (status == 0)
+    {
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(entries, sizeof(ArcadePackEntry), count, file);
+        for (int i = 0; i < count; i++)
+            fwrite(sources[i].name, strlen(sources[i].name) + 1, 1, file);
+        offset = (uint64_t)header.names_offset + header.names_size;
+    }
+    static const unsigned char padding[ARCADE_PIXEL_ALIGNMENT];
+    for (int i = 0; i < count && status == 0; i++)
+    {
+        ArcadeImageAsset *image = decode_image_asset(sources[i].name, sources[i].width, sources[i].height);
+        if (!image)
+        {
+            status = 1;
+            break;
+        }
+        fwrite(padding, 1, entries[i].pixel_offset - offset, file);
+        fwrite(image->pixels, sizeof(uint32_t), (size_t)image->width * image->height, file);
+        if (image->opaque_rows)
+            fwrite(image->opaque_rows, 1, image->height, file);
+        else
+            for (int y = 0; y < image->height; y++)
+                fputc(0, file);
+        offset = entries[i].opaque_offset + entries[i].height;
+        free_asset(image);
+    }
+    int write_failed = file ? ferror(file) : 0;
+    if (file && (fclose(file) != 0 || write_failed) && status == 0)
+    {
+        fprintf(stderr, "Failed to write pack %s\n", pack_path);
+        status = 1;
+    }
+    if (file && status != 0)
+        remove(pack_path);
+    free(sources);
+    free(entries);
+    return status;
+}
+
+static int validate_pack(const unsigned char *base, size_t size)
+{
+    /* Everything sprites will read must lie inside the file */
+    if (size < sizeof(ArcadePackHeader))
+        return 0;
+    const ArcadePackHeader *header = (const ArcadePackHeader *)base;
+    if (memcmp(header->magic, ARCADE_PACK_MAGIC, sizeof(header->magic)) != 0 || header->version != ARCADE_PACK_VERSION)
+        return 0;
+    uint64_t index_end = sizeof(ArcadePackHeader) + (uint64_t)header->entry_count * sizeof(ArcadePackEntry);
+    if (index_end > header->names_offset || (uint64_t)header->names_offset + header->names_size > size ||
+        header->names_size == 0 || base[header->names_offset + header->names_size - 1] != '\0')
+        return 0;
+    const ArcadePackEntry *entries = (const ArcadePackEntry *)(base + sizeof(ArcadePackHeader));
+    const char *names = (const char *)base + header->names_offset;
+    for (uint32_t i = 0; i < header->entry_count; i++)
+    {
+        const ArcadePackEntry *e = &entries[i];
+        if (e->name_offset >= header->names_size || e->width == 0 || e->height == 0 ||
+            e->width > ARCADE_PACK_MAX_DIMENSION || e->height > ARCADE_PACK_MAX_DIMENSION ||
+            e->pixel_offset % sizeof(uint32_t) != 0)
+            return 0;
+        /* Compare remaining space rather than adding to the offsets, which could wrap */
+        if (e->pixel_offset > size || (uint64_t)e->width * e->height * sizeof(uint32_t) > size - e->pixel_offset ||
+            e->opaque_offset > size || e->height > size - e->opaque_offset)
+            return 0;
+        if (i > 0 && strcmp(names + entries[i - 1].name_offset, names + e->name_offset) >= 0)
+            return 0; /* Lookups binary-search the names */
+    }
+    return 1;
+}
+
+ArcadePack *arcade_open_pack(const char *pack_path)
+{
+    size_t size = 0;
+    void *base = pack_path ? map_file(pack_path, &size) : NULL;
+    if (!base)
+    {
+        fprintf(stderr, "Cannot open pack %s\n", pack_path ? pack_path : "(null)");
+        return NULL;
+    }
+    ArcadePack *pack = NULL;
+    ArcadeImageAsset *asset = NULL;
+    if (validate_pack(base, size))
+    {
+        pack = calloc(1, sizeof(ArcadePack));
+        asset = calloc(1, sizeof(ArcadeImageAsset));
+    }
+    else
+        fprintf(stderr, "%s is not a valid asset pack\n", pack_path);
+    if (!pack || !asset)
+    {
+        free(pack);
+        free(asset);
+        unmap_file(base, size);
+        return NULL;
+    }
+    const ArcadePackHeader *header = base;
+    asset->mapping = base;
+    asset->mapping_bytes = size;
+    asset->refs = 1;
+    register_asset(asset);
+    pack->asset = asset;
+    pack->base = base;
+    pack->entries = (const ArcadePackEntry *)(pack->base + sizeof(ArcadePackHeader));
+    pack->entry_count = header->entry_count;
+    pack->names = (const char *)pack->base + header->names_offset;
+    return pack;
+}
+
+ArcadeImageSprite arcade_create_pack_sprite(ArcadePack *pack, const char *name, float x, float y)
+{
+    ArcadeImageSprite sprite = {.x = x, .y = y};
+    if (!pack || !name)
+        return sprite;
+    uint32_t lo = 0, hi = pack->entry_count;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int order = strcmp(pack->names + pack->entries[mid].name_offset, name);
+        if (order == 0)
+        {
+            const ArcadePackEntry *entry = &pack->entries[mid];
+            retain_image_asset(pack->asset);
+            sprite.asset = pack->asset;
+            /* Copy-on-write mapping: edits stay private to this process */
+            sprite.pixels = (uint32_t *)(pack->base + entry->pixel_offset);
+            sprite.opaque_rows = (uint8_t *)(pack->base + entry->opaque_offset);
+            sprite.image_width = (int)entry->width;
+            sprite.image_height = (int)entry->height;
+            sprite.stride = (int)entry->width;
+            sprite.width = (float)entry->width;
+            sprite.height = (float)entry->height;
+            sprite.active = 1;
+            return sprite;
+        }
+        if (order < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    fprintf(stderr, "%s is not in the pack\n", name);
+    return sprite;
+}
+
+void arcade_close_pack(ArcadePack *pack)
+{
+    if (!pack)
+        return;
+    release_image_asset(pack->asset);
+    free(pack);
+}
+
+/* =========================================================================
+ * Sprite Management
+ * ========================================================================= */
+
+static void move_sprite(ArcadeSprite *sprite, float gravity, int window_height)
+{
+    if (!sprite || !sprite->active)
+        return;
+    sprite->vy += gravity;
+    sprite->y += sprite->vy;
+    sprite->x += sprite->vx;
+    if (sprite->y < 0.0f)
+    {
+        sprite->y = 0.0f;
+        sprite->vy = 0.0f;
+    }
+    if (sprite->y > window_height - sprite->height)
+    {
+        sprite->y = window_height - sprite->height;
+        sprite->vy = 0.0f;
+    }
+}
+
+void arcade_move_sprite(ArcadeSprite *sprite, float gravity, int window_height)
+{
+    if (sprite)
+        move_sprite(sprite, gravity, window_height);
+}
+
+void arcade_move_image_sprite(ArcadeImageSprite *sprite, float gravity, int window_height)
+{
+    if (!sprite || !sprite->active)
+        return;
+    sprite->vy += gravity;
+    sprite->y += sprite->vy;
+    sprite->x += sprite->vx;
+    if (sprite->y < 0.0f)
+    {
+        sprite->y = 0.0f;
+        sprite->vy = 0.0f;
+    }
+    if (sprite->y > window_height - sprite->height)
+    {
+        sprite->y = window_height - sprite->height;
+        sprite->vy = 0.0f;
+    }
+}
+
+void arcade_set_image_sprite_orientation(ArcadeImageSprite *sprite, int orientation)
+{
+    if (!sprite)
+        return;
+    /* The on-screen box turns with the image when the quarter-turn parity changes */
+    if ((sprite->orientation ^ orientation) & ARCADE_ORIENT_ROTATE_90)
+    {
+        float width = sprite->width;
+        sprite->width = sprite->height;
+        sprite->height = width;
+    }
+    sprite->orientation = orientation & 15;
+}
+
+ArcadeAffineSprite arcade_create_affine_sprite(ArcadeImageSprite image)
+{
+    ArcadeAffineSprite sprite = {.image = image, .scale_x = 1.0f, .scale_y = 1.0f, .filter = ARCADE_FILTER_NEAREST};
+    sprite.origin_x = image.width * 0.5f;
+    sprite.origin_y = image.height * 0.5f;
+    return sprite;
+}
+
+static int check_collision(const ArcadeSprite *a, const ArcadeSprite *b)
+{
+    if (!a || !b || !a->active || !b->active)
+        return 0;
+    return (a->x < b->x + b->width &&
+            a->x + a->width > b->x &&
+            a->y < b->y + b->height &&
+            a->y + a->height > b->y);
+}
+
+int arcade_check_collision(ArcadeSprite *a, ArcadeSprite *b)
+{
+    if (!a || !b)
+        return 0;
+    return check_collision(a, b);
+}
+
+int arcade_check_image_collision(ArcadeImageSprite *a, ArcadeImageSprite *b)
+{
+    if (!a || !b || !a->active || !b->active)
+        return 0;
+    return (a->x < b->x + b->width &&
+            a->x + a->width > b->x &&
+            a->y < b->y + b->height &&
+            a->y + a->height > b->y);
+}
+
+static ArcadeImageSprite sprite_from_asset(ArcadeImageAsset *asset, float x, float y)
+{
+    /* Wraps a reference to asset (which the sprite takes over) in a sprite */
+    ArcadeImageSprite sprite = {
+        .x = x, .y = y, .width = 0.0f, .height = 0.0f, .vx = 0.0f, .vy = 0.0f, .pixels = NULL, .image_width = 0, .image_height = 0, .active = 1, .opaque_rows = NULL, .asset = NULL, .stride = 0, .orientation = 0};
+    if (asset)
+    {
+        /* Pixels are shared with every other sprite of the same file and size */
+        sprite.asset = asset;
+        sprite.pixels = asset->pixels;
+        sprite.opaque_rows = asset->opaque_rows;
+        sprite.image_width = asset->width;
+        sprite.image_height = asset->height;
+        sprite.stride = asset->width;
+        sprite.width = (float)asset->width;
+        sprite.height = (float)asset->height;
+    }
+    return sprite;
+}
+
+ArcadeImageSprite arcade_create_image_sprite(float x, float y, float w, float h, const char *filename)
+{
+    return sprite_from_asset(filename ? acquire_image_asset(filename, (int)w, (int)h) : NULL, x, y);
+}
+
+ArcadeImageSprite arcade_retain_image_sprite(const ArcadeImageSprite *sprite)
+{
+    if (sprite->asset)
+        retain_image_asset(sprite->asset);
+    return *sprite;
+}
+
+void arcade_release_image_sprite(ArcadeImageSprite *sprite)
+{
+    if (!sprite || !sprite->pixels)
+        return;
+    if (sprite->asset)
+        release_image_asset(sprite->asset);
+    else
+    {
+        /* Pixels allocated by the caller and handed to the sprite */
+        free(sprite->pixels);
+        free(sprite->opaque_rows);
+    }
+    sprite->asset = NULL;
+    sprite->pixels = NULL;
+    sprite->opaque_rows = NULL;
+    sprite->image_width = 0;
+    sprite->image_height = 0;
+    sprite->stride = 0;
+    sprite->orientation = 0;
+    sprite->active = 0;
+}
+
+void arcade_free_image_sprite(ArcadeImageSprite *sprite)
+{
+    arcade_release_image_sprite(sprite);
+}
+
+ArcadeAnimatedSprite arcade_create_animated_sprite(float x, float y, float w, float h, const char **filenames, int frame_count, int frame_interval)
+{
+    ArcadeAnimatedSprite anim = {0};
+    anim.frames = malloc(frame_count * sizeof(ArcadeImageSprite));
+    anim.frame_count = frame_count;
+    anim.frame_interval = frame_interval;
+    for (int i = 0; i < frame_count; i++)
+    {
+        anim.frames[i] = arcade_create_image_sprite(x, y, w, h, filenames[i]);
+        if (!anim.frames[i].pixels)
+        {
+            for (int j = 0; j < i; j++)
+                arcade_free_image_sprite(&anim.frames[j]);
+            free(anim.frames);
+            return (ArcadeAnimatedSprite){0};
+        }
+    }
+    anim.frames[0].active = 1;
+    return anim;
+}
+
+void arcade_free_animated_sprite(ArcadeAnimatedSprite *anim)
+{
+    if (!anim || !anim->frames)
+        return;
+    for (int i = 0; i < anim->frame_count; i++)
+        arcade_free_image_sprite(&anim->frames[i]);
+    free(anim->frames);
+    anim->frames = NULL;
+    anim->frame_count = 0;
+}
+
+void arcade_move_animated_sprite(ArcadeAnimatedSprite *anim, float gravity, int window_height)
+{
+    if (!anim || !anim->frames[0].active)
+        return;
+    ArcadeImageSprite *current = &anim->frames[anim->current_frame];
+    arcade_move_image_sprite(current, gravity, window_height);
+    for (int i = 0; i < anim->frame_count; i++)
+    {
+        anim->frames[i].x = current->x;
+        anim->frames[i].y = current->y;
+        anim->frames[i].vx = current->vx;
+        anim->frames[i].vy = current->vy;
+    }
+    if (++anim->frame_counter >= anim->frame_interval)
+    {
+        anim->current_frame = (anim->current_frame + 1) % anim->frame_count;
+        anim->frame_counter = 0;
+    }
+}
+
+int arcade_check_animated_collision(ArcadeAnimatedSprite *anim, ArcadeImageSprite *other)
+{
+    if (!anim || !other || !anim->frames[0].active || !other->active)
+        return 0;
+    return arcade_check_image_collision(&anim->frames[anim->current_frame], other);
+}
+
+/* Shared, immutable part of an animation; instances only keep a pointer to it */
+struct ArcadeAnimClip
+{
+    ArcadeImageSprite *frames; /* One sprite per frame, each holding a reference to its pixels */
+    int frame_count;           /* Number of frames */
+    int frame_interval;        /* Ticks per frame */
+    int *frame_ticks;          /* Per-frame ticks overriding frame_interval (GIF delays), or NULL */
+};
+
+static ArcadeAnimClip *alloc_anim_clip(int frame_count, int frame_interval)
+{
+    if (frame_count <= 0)
+        return NULL;
+    ArcadeAnimClip *clip = calloc(1, sizeof(ArcadeAnimClip));
+    if (clip)
+        clip->frames = calloc(frame_count, sizeof(ArcadeImageSprite));
+    if (clip && !clip->frames)
+    {
+        free(clip);
+        return NULL;
+    }
+    if (clip)
+    {
+        clip->frame_count = frame_count;
+        clip->frame_interval = frame_interval > 0 ? frame_interval : 1;
+    }
+    return clip;
+}
+
+ArcadeAnimClip *arcade_create_anim_clip(float w, float h, const char **filenames, int frame_count, int frame_interval)
+{
+    if (!filenames)
+        return NULL;
+    ArcadeAnimClip *clip = alloc_anim_clip(frame_count, frame_interval);
+    if (!clip)
+        return NULL;
+    for (int i = 0; i < frame_count; i++)
+    {
+        clip->frames[i] = arcade_create_image_sprite(0.0f, 0.0f, w, h, filenames[i]);
+        if (!clip->frames[i].pixels)
+        {
+            arcade_free_anim_clip(clip);
+            return NULL;
+        }
+    }
+    return clip;
+}
+
+ArcadeAnimClip *arcade_create_anim_clip_from_sprites(const ArcadeImageSprite *frames, int frame_count, int frame_interval)
+{
+    if (!frames)
+        return NULL;
+    for (int i = 0; i < frame_count; i++)
+        if (!frames[i].pixels)
+            return NULL;
+    ArcadeAnimClip *clip = alloc_anim_clip(frame_count, frame_interval);
+    if (!clip)
+        return NULL;
+    for (int i = 0; i < frame_count; i++)
+    {
+        clip->frames[i] = arcade_retain_image_sprite(&frames[i]);
+        clip->frames[i].x = 0.0f;
+        clip->frames[i].y = 0.0f;
+        clip->frames[i].active = 1;
+    }
+    return clip;
+}
+
+static ArcadeAnimClip *build_strip_clip(const unsigned char *sheet, int sheet_width, int sheet_height, const int *rects,
+                                        int frame_count, int width, int height, int frame_interval, const char *name)
+{
+    /* Cuts frames out of one decoded RGBA image into a single contiguous asset,
+     * frame after frame, each resized to width x height (0 = size of the first rect) */
+    if (!sheet || !rects || frame_count <= 0)
+        return NULL;
+    if (width <= 0 || height <= 0)
+    {
+        width = rects[2];
+        height = rects[3];
+    }
+    for (int i = 0; i < frame_count; i++)
+    {
+        const int *r = rects + i * 4;
+        if (r[0] < 0 || r[1] < 0 || r[2] <= 0 || r[3] <= 0 || r[0] + r[2] > sheet_width || r[1] + r[3] > sheet_height)
+        {
+            fprintf(stderr, "Frame %d (%d,%d %dx%d) lies outside %s (%dx%d)\n", i, r[0], r[1], r[2], r[3], name,
+                    sheet_width, sheet_height);
+            return NULL;
+        }
+    }
+    if (width <= 0 || height <= 0)
+        return NULL;
+    ArcadeAnimClip *clip = alloc_anim_clip(frame_count, frame_interval);
+    ArcadeImageAsset *asset = clip ? calloc(1, sizeof(ArcadeImageAsset)) : NULL;
+    size_t frame_pixels = (size_t)width * height;
+    if (asset)
+    {
+        asset->pixels = alloc_pixels(frame_pixels * frame_count * sizeof(uint32_t));
+        asset->opaque_rows = malloc((size_t)height * frame_count);
+    }
+    if (!asset || !asset->pixels || !asset->opaque_rows)
+    {
+        if (asset)
+            free_asset(asset);
+        arcade_free_anim_clip(clip);
+        return NULL;
+    }
+    asset->width = width;
+    asset->height = height * frame_count;
+    asset->bytes = frame_pixels * frame_count * sizeof(uint32_t) + (size_t)height * frame_count;
+    for (int i = 0; i < frame_count; i++)
+    {
+        const int *r = rects + i * 4;
+        const unsigned char *src = sheet + ((size_t)r[1] * sheet_width + r[0]) * 4;
+        size_t src_stride = (size_t)sheet_width * 4;
+        uint32_t *dst = asset->pixels + frame_pixels * i;
+        if (r[2] != width || r[3] != height)
+        {
+            /* Resize into the frame's slot, then convert it in place */
+            if (stbir_resize_uint8_srgb(src, r[2], r[3], (int)src_stride, (unsigned char *)dst, width, height, 0, 4) == 0)
+            {
+                fprintf(stderr, "Failed to resize frame %d of %s\n", i, name);
+                free_asset(asset);
+                arcade_free_anim_clip(clip);
+                return NULL;
+            }
+            src = (const unsigned char *)dst;
+            src_stride = (size_t)width * 4;
+        }
+        for (int y = 0; y < height; y++)
+            asset->opaque_rows[i * height + y] =
+                kernels.premultiply(dst + (size_t)y * width, src + y * src_stride, width) == 255;
+    }
+    /* Every frame holds a reference to the shared strip */
+    asset->refs = frame_count;
+    register_asset(asset);
+    for (int i = 0; i < frame_count; i++)
+    {
+        ArcadeImageSprite *frame = &clip->frames[i];
+        frame->asset = asset;
+        frame->pixels = asset->pixels + frame_pixels * i;
+        frame->opaque_rows = asset->opaque_rows + (size_t)height * i;
+        frame->image_width = width;
+        frame->image_height = height;
+        frame->stride = width;
+        frame->width = (float)width;
+        frame->height = (float)height;
+        frame->active = 1;
+    }
+    return clip;
+}
+
+ArcadeAnimClip *arcade_create_anim_clip_from_rects(const char *filename, const int *rects, int frame_count, float w, float h,
+                                                   int frame_interval)
+{
+    if (!filename || !rects || frame_count <= 0)
+        return NULL;
+    int sheet_width, sheet_height, channels;
+    unsigned char *sheet = stbi_load(filename, &sheet_width, &sheet_height, &channels, 4);
+    if (!sheet)
+    {
+        fprintf(stderr, "Cannot load %s\n", filename);
+        return NULL;
+    }
+    ArcadeAnimClip *clip = build_strip_clip(sheet, sheet_width, sheet_height, rects, frame_count, (int)w, (int)h,
+                                            frame_interval, filename);
+    stbi_image_free(sheet);
+    return clip;
+}
+
+ArcadeAnimClip *arcade_create_anim_clip_from_sheet(const char *filename, int cell_width, int cell_height, int frame_count,
+                                                   float w, float h, int frame_interval)
+{
+    if (!filename || cell_width <= 0 || cell_height <= 0)
+        return NULL;
+    int sheet_width, sheet_height, channels;
+    unsigned char *sheet = stbi_load(filename, &sheet_width, &sheet_height, &channels, 4);
+    if (!sheet)
+    {
+        fprintf(stderr, "Cannot load %s\n", filename);
+        return NULL;
+    }
+    /* Cells are read left to right, top to bottom */
+    int columns = sheet_width / cell_width;
+    int cells = columns * (sheet_height / cell_height);
+    if (frame_count <= 0 || frame_count > cells)
+        frame_count = cells;
+    int *rects = frame_count > 0 ? malloc(frame_count * 4 * sizeof(int)) : NULL;
+    ArcadeAnimClip *clip = NULL;
+    if (rects)
+    {
+        for (int i = 0; i < frame_count; i++)
+        {
+            rects[i * 4] = (i % columns) * cell_width;
+            rects[i * 4 + 1] = (i / columns) * cell_height;
+            rects[i * 4 + 2] = cell_width;
+            rects[i * 4 + 3] = cell_height;
+        }
+        clip = build_strip_clip(sheet, sheet_width, sheet_height, rects, frame_count, (int)w, (int)h, frame_interval, filename);
+    }
+    else
+        fprintf(stderr, "No %dx%d cells in %s\n", cell_width, cell_height, filename);
+    free(rects);
+    stbi_image_free(sheet);
+    return clip;
+}
+
+ArcadeAnimClip *arcade_create_anim_clip_from_gif(const char *filename, float w, float h)
+{
+    /* stb_image only decodes GIF animations from memory: read the file in one go */
+    FILE *file = filename ? fopen(filename, "rb") : NULL;
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", filename ? filename : "(null)");
+        return NULL;
+    }
+    unsigned char *data = NULL;
+    long size = 0;
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 && size <= INT_MAX && fseek(file, 0, SEEK_SET) == 0)
+    {
+        data = malloc(size);
+        if (data && fread(data, 1, size, file) != (size_t)size)
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data)
+    {
+        fprintf(stderr, "Cannot read %s\n", filename);
+        return NULL;
+    }
+    int *delays = NULL;
+    int width, height, frame_count, channels;
+    unsigned char *frames = stbi_load_gif_from_memory(data, (int)size, &delays, &width, &height, &frame_count, &channels, 4);
+    free(data);
+    if (!frames)
+    {
+        fprintf(stderr, "Cannot decode GIF %s\n", filename);
+        return NULL;
+    }
+    /* stb_image stacks the frames vertically, so the GIF is a one-column sheet */
+    int *rects = malloc(frame_count * 4 * sizeof(int));
+    ArcadeAnimClip *clip = NULL;
+    if (rects)
+    {
+        for (int i = 0; i < frame_count; i++)
+        {
+            rects[i * 4] = 0;
+            rects[i * 4 + 1] = i * height;
+            rects[i * 4 + 2] = width;
+            rects[i * 4 + 3] = height;
+        }
+        clip = build_strip_clip(frames, width, height * frame_count, rects, frame_count, (int)w, (int)h, 1, filename);
+    }
+    if (clip && delays)
+        clip->frame_ticks = malloc(frame_count * sizeof(int));
+    if (clip && clip->frame_ticks)
+    {
+        /* GIF delays are in milliseconds; instances advance one tick per move at ~60 FPS */
+        for (int i = 0; i < frame_count; i++)
+        {
+            int ticks = (delays[i] * 60 + 500) / 1000;
+            clip->frame_ticks[i] = ticks > 0 ? ticks : 1;
+        }
+    }
+    free(rects);
+    stbi_image_free(delays);
+    stbi_image_free(frames);
+    return clip;
+}
+
+void arcade_free_anim_clip(ArcadeAnimClip *clip)
+{
+    if (!clip)
+        return;
+    for (int i = 0; i < clip->frame_count; i++)
+        arcade_release_image_sprite(&clip->frames[i]);
+    free(clip->frames);
+    free(clip->frame_ticks);
+    free(clip);
+}
+
+ArcadeAnimInstance arcade_create_anim_instance(const ArcadeAnimClip *clip, float x, float y)
+{
+    ArcadeAnimInstance instance = {.clip = clip, .x = x, .y = y, .active = clip != NULL};
+    return instance;
+}
+
+void arcade_move_anim_instance(ArcadeAnimInstance *instance, float gravity, int window_height)
+{
+    /* Same motion as arcade_move_image_sprite, but only this instance's few fields change */
+    if (!instance || !instance->active || !instance->clip)
+        return;
+    const ArcadeAnimClip *clip = instance->clip;
+    float height = clip->frames[instance->current_frame].height;
+    instance->vy += gravity;
+    instance->y += instance->vy;
+    instance->x += instance->vx;
+    if (instance->y < 0.0f)
+    {
+        instance->y = 0.0f;
+        instance->vy = 0.0f;
+    }
+    if (instance->y > window_height - height)
+    {
+        instance->y = window_height - height;
+        instance->vy = 0.0f;
+    }
+    int ticks = clip->frame_ticks ? clip->frame_ticks[instance->current_frame] : clip->frame_interval;
+    if (++instance->frame_counter >= ticks)
+    {
+        instance->current_frame = (instance->current_frame + 1) % clip->frame_count;
+        instance->frame_counter = 0;
+    }
+}
+
+ArcadeImageSprite arcade_anim_instance_sprite(const ArcadeAnimInstance *instance)
+{
+    if (!instance || !instance->clip)
+        return (ArcadeImageSprite){0};
+    ArcadeImageSprite sprite = instance->clip->frames[instance->current_frame];
+    sprite.x = instance->x;
+    sprite.y = instance->y;
+    sprite.vx = instance->vx;
+    sprite.vy = instance->vy;
+    sprite.active = instance->active;
+    return sprite;
+}
+
+int arcade_check_anim_instance_collision(const ArcadeAnimInstance *instance, ArcadeImageSprite *other)
+{
+    if (!instance || !instance->active || !instance->clip)
+        return 0;
+    ArcadeImageSprite current = arcade_anim_instance_sprite(instance);
+    return arcade_check_image_collision(&current, other);
+}
+
+/* =========================================================================
+ * Asynchronous Loading
+ * Image decoding runs on a pool of loader threads through the asset cache.
+ * Workers only decode; a load's status changes on the main thread, when
+ * arcade_poll_loads notices that all of its frames are done.
+ * ========================================================================= */
+struct ArcadeLoad
+{
+    int status;                      /* Reported status (ARCADE_LOAD_*), updated by arcade_poll_loads */
+    int animated;                    /* 1 = finish as an animated sprite */
+    int abandoned;                   /* 1 = cancelled while pending; freed once complete */
+    float x, y, w, h;                /* Sprite position and size */
+    int frame_interval;              /* Animation speed (animated loads only) */
+    int frame_count;                 /* Number of images */
+    char **paths;                    /* Image files */
+    ArcadeImageAsset **assets;       /* Decoded images, written by the workers */
+    int next_frame;                  /* Next frame to hand to a worker (guarded by loader.lock) */
+    volatile long remaining;         /* Frames not decoded yet */
+    volatile long failed;            /* 1 if any frame failed to load */
+    struct ArcadeLoad *next;         /* Next load waiting for a worker */
+    struct ArcadeLoad *next_pending; /* Next load not yet reported by arcade_poll_loads */
+};
+
+static struct
+{
+    ArcadeMutex lock;                                /* Guards everything below */
+    ArcadeCond work_ready;                           /* Signalled when frames are queued or on shutdown */
+    ArcadeThread threads[ARCADE_MAX_LOADER_THREADS]; /* Running workers */
+    int thread_count;                                /* Number of running workers */
+    int shutdown;                                    /* 1 = workers exit */
+    ArcadeLoad *queue_head, *queue_tail;             /* Loads with frames left to hand out, FIFO */
+    ArcadeLoad *pending;                             /* Loads not yet reported as done */
+} loader = {.lock = ARCADE_MUTEX_INITIALIZER, .work_ready = ARCADE_COND_INITIALIZER};
+
+static void free_load(ArcadeLoad *load)
+{
+    /* Drops the frames that were not handed over to a sprite */
+    for (int i = 0; i < load->frame_count; i++)
+    {
+        if (load->assets && load->assets[i])
+            release_image_asset(load->assets[i]);
+        if (load->paths)
+            free(load->paths[i]);
+    }
+    free(load->assets);
+    free(load->paths);
+    free(load);
+}
+
+ARCADE_THREAD_FUNC(loader_worker)
+{
+    (void)arg;
+    mutex_lock(&loader.lock);
+    for (;;)
+    {
+        while (!loader.shutdown && !loader.queue_head)
+            cond_wait(&loader.work_ready, &loader.lock);
+        if (loader.shutdown)
+            break;
+        ArcadeLoad *load = loader.queue_head;
+        int frame = load->next_frame++;
+        if (load->next_frame == load->frame_count)
+        {
+            loader.queue_head = load->next;
+            if (!loader.queue_head)
+                loader.queue_tail = NULL;
+        }
+        mutex_unlock(&loader.lock);
+        ArcadeImageAsset *asset = acquire_image_asset(load->paths[frame], (int)load->w, (int)load->h);
+        load->assets[frame] = asset;
+        if (!asset)
+            atomic_store_int(&load->failed, 1);
+        /* Publishes assets[frame] to arcade_poll_loads */
+        atomic_fetch_add_int(&load->remaining, -1);
+        mutex_lock(&loader.lock);
+    }
+    mutex_unlock(&loader.lock);
+    ARCADE_THREAD_RETURN;
+}
+
+static int reap_loads_locked(void)
+{
+    /* Reports finished loads and frees cancelled ones; returns how many are still pending */
+    int pending = 0;
+    for (ArcadeLoad **link = &loader.pending; *link;)
+    {
+        ArcadeLoad *load = *link;
+        if (atomic_load_int(&load->remaining) > 0)
+        {
+            pending++;
+            link = &load->next_pending;
+            continue;
+        }
+        *link = load->next_pending;
+        if (load->abandoned)
+            free_load(load);
+        else
+            load->status = atomic_load_int(&load->failed) ? ARCADE_LOAD_FAILED : ARCADE_LOAD_DONE;
+    }
+    return pending;
+}
+
+static void stop_loader_locked(void)
+{
+    if (loader.thread_count > 0)
+    {
+        loader.shutdown = 1;
+        cond_broadcast(&loader.work_ready);
+        mutex_unlock(&loader.lock);
+        for (int i = 0; i < loader.thread_count; i++)
+            thread_join(loader.threads[i]);
+        mutex_lock(&loader.lock);
+        loader.thread_count = 0;
+        loader.shutdown = 0;
+    }
+    /* Frames nobody picked up fail, so every load still completes */
+    for (ArcadeLoad *load = loader.queue_head; load; load = load->next)
+    {
+        atomic_store_int(&load->failed, 1);
+        atomic_fetch_add_int(&load->remaining, load->next_frame - load->frame_count);
+        load->next_frame = load->frame_count;
+    }
+    loader.queue_head = loader.queue_tail = NULL;
+    reap_loads_locked();
+}
+
+static int start_loader_locked(int threads)
+{
+    if (threads > ARCADE_MAX_LOADER_THREADS)
+        threads = ARCADE_MAX_LOADER_THREADS;
+    for (int i = 0; i < threads; i++)
+    {
+        if (thread_start(&loader.threads[loader.thread_count], loader_worker, NULL) != 0)
+            break;
+        loader.thread_count++;
+    }
+    if (loader.thread_count < threads)
+    {
+        fprintf(stderr, "Cannot start loader threads\n");
+        stop_loader_locked();
+        return 1;
+    }
+    return 0;
+}
+
+int arcade_set_loader_threads(int threads)
+{
+    mutex_lock(&loader.lock);
+    stop_loader_locked();
+    int status = threads > 0 ? start_loader_locked(threads) : 0;
+    mutex_unlock(&loader.lock);
+    return status;
+}
+
+static ArcadeLoad *queue_load(float x, float y, float w, float h, const char **filenames, int frame_count)
+{
+    if (!filenames || frame_count <= 0)
+        return NULL;
+    ArcadeLoad *load = calloc(1, sizeof(ArcadeLoad));
+    if (!load)
+        return NULL;
+    load->x = x;
+    load->y = y;
+    load->w = w;
+    load->h = h;
+    load->frame_count = frame_count;
+    load->paths = calloc(frame_count, sizeof(char *));
+    load->assets = calloc(frame_count, sizeof(ArcadeImageAsset *));
+    int ok = load->paths && load->assets;
+    for (int i = 0; ok && i < frame_count; i++)
+    {
+        load->paths[i] = filenames[i] ? malloc(strlen(filenames[i]) + 1) : NULL;
+        ok = load->paths[i] != NULL;
+        if (ok)
+            strcpy(load->paths[i], filenames[i]);
+    }
+    if (!ok)
+    {
+        free_load(load);
+        return NULL;
+    }
+    load->remaining = frame_count;
+    load->status = ARCADE_LOAD_PENDING;
+
+    mutex_lock(&loader.lock);
+    /* Start one worker per core on first use */
+    if (loader.thread_count == 0 && start_loader_locked(cpu_count()) != 0)
+    {
+        mutex_unlock(&loader.lock);
+        free_load(load);
+        return NULL;
+    }
+    if (loader.queue_tail)
+        loader.queue_tail->next = load;
+    else
+        loader.queue_head = load;
+    loader.queue_tail = load;
+    load->next_pending = loader.pending;
+    loader.pending = load;
+    cond_broadcast(&loader.work_ready);
+    mutex_unlock(&loader.lock);
+    return load;
+}
+
+ArcadeLoad *arcade_load_image_sprite_async(float x, float y, float w, float h, const char *filename)
+{
+    return queue_load(x, y, w, h, &filename, 1);
+}
+
+ArcadeLoad *arcade_load_animated_sprite_async(float x, float y, float w, float h, const char **filenames, int frame_count, int frame_interval)
+{
+    ArcadeLoad *load = queue_load(x, y, w, h, filenames, frame_count);
+    if (load)
+    {
+        /* Only read by the finish call on this thread */
+        load->animated = 1;
+        load->frame_interval = frame_interval;
+    }
+    return load;
+}
+
+int arcade_poll_loads(void)
+{
+    mutex_lock(&loader.lock);
+    int pending = reap_loads_locked();
+    mutex_unlock(&loader.lock);
+    return pending;
+}
+
+int arcade_load_status(const ArcadeLoad *load)
+{
+    return load ? load->status : ARCADE_LOAD_FAILED;
+}
+
+ArcadeImageSprite arcade_finish_image_load(ArcadeLoad *load)
+{
+    ArcadeImageSprite sprite = {0};
+    if (!load || load->status == ARCADE_LOAD_PENDING)
+        return sprite;
+    if (load->status == ARCADE_LOAD_DONE && !load->animated)
+    {
+        /* The load's reference moves to the sprite */
+        sprite = sprite_from_asset(load->assets[0], load->x, load->y);
+        load->assets[0] = NULL;
+    }
+    free_load(load);
+    return sprite;
+}
+
+ArcadeAnimatedSprite arcade_finish_animated_load(ArcadeLoad *load)
+{
+    ArcadeAnimatedSprite anim = {0};
+    if (!load || load->status == ARCADE_LOAD_PENDING)
+        return anim;
+    if (load->status == ARCADE_LOAD_DONE && load->animated)
+        anim.frames = malloc(load->frame_count * sizeof(ArcadeImageSprite));
+    if (anim.frames)
+    {
+        for (int i = 0; i < load->frame_count; i++)
+        {
+            anim.frames[i] = sprite_from_asset(load->assets[i], load->x, load->y);
+            load->assets[i] = NULL;
+        }
+        anim.frame_count = load->frame_count;
+        anim.frame_interval = load->frame_interval;
+    }
+    free_load(load);
+    return anim;
+}
+
+void arcade_cancel_load(ArcadeLoad *load)
+{
+    if (!load)
+        return;
+    mutex_lock(&loader.lock);
+    if (load->status == ARCADE_LOAD_PENDING)
+    {
+        /* Workers may still be decoding; the next poll frees it */
+        load->abandoned = 1;
+        mutex_unlock(&loader.lock);
+        return;
+    }
+    mutex_unlock(&loader.lock);
+    free_load(load);
+}
+
+/* =========================================================================
+ * Rendering
+ * ========================================================================= */
+
+typedef struct
+{
+    int width, height;   /* Source rectangle drawn, clamped like an image sprite */
+    double ax, ay;       /* Source position of screen point (0, 0) */
+    double xx, xy;       /* Source step per screen pixel to the right */
+    double yx, yy;       /* Source step per screen row down */
+    ArcadeRegion bounds; /* Screen pixels the sprite can touch */
+} ArcadeAffineMap;
+
+static int affine_map(const ArcadeAffineSprite *s, ArcadeAffineMap *m)
+{
+    /* A source point p lands on the screen at T + R*S*(p - origin), where T is the
+     * position plus the origin; inverting that gives the source point under any
+     * screen point. Returns 0 if nothing would be drawn. */
+    const ArcadeImageSprite *img = &s->image;
+    if (!img->active || !img->pixels)
+        return 0;
+    m->width = (int)img->width < img->image_width ? (int)img->width : img->image_width;
+    m->height = (int)img->height < img->image_height ? (int)img->height : img->image_height;
+    if (m->width <= 0 || m->height <= 0 || img->image_width > 32767 || img->image_height > 32767 ||
+        fabsf(s->scale_x) < 1.0f / 1024.0f || fabsf(s->scale_y) < 1.0f / 1024.0f)
+        return 0;
+    /* Right angles are exact so quarter turns sample whole pixels */
+    double angle = fmod((double)s->angle, 360.0);
+    if (angle < 0.0)
+        angle += 360.0;
+    double c, sn;
+    if (angle == 0.0 || angle == 90.0 || angle == 180.0 || angle == 270.0)
+    {
+        c = angle == 0.0 ? 1.0 : angle == 180.0 ? -1.0 : 0.0;
+        sn = angle == 90.0 ? 1.0 : angle == 270.0 ? -1.0 : 0.0;
+    }
+    else
+    {
+        c = cos(angle * 3.14159265358979323846 / 180.0);
+        sn = sin(angle * 3.14159265358979323846 / 180.0);
+    }
+    double sx = s->scale_x, sy = s->scale_y, ox = s->origin_x, oy = s->origin_y;
+    double tx = img->x + ox, ty = img->y + oy;
+    m->xx = c / sx;
+    m->xy = -sn / sy;
+    m->yx = sn / sx;
+    m->yy = c / sy;
+    m->ax = ox - tx * m->xx - ty * m->yx;
+    m->ay = oy - tx * m->xy - ty * m->yy;
+
+    /* Bilinear samples fade out over the half pixel beyond each edge */
+    double margin = s->filter == ARCADE_FILTER_BILINEAR ? 0.5 : 0.0;
+    double min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        double dx = ((i & 1 ? m->width + margin : -margin) - ox) * sx;
+        double dy = ((i & 2 ? m->height + margin : -margin) - oy) * sy;
+        double x = tx + c * dx - sn * dy, y = ty + sn * dx + c * dy;
+        if (i == 0 || x < min_x)
+            min_x = x;
+        if (i == 0 || x > max_x)
+            max_x = x;
+        if (i == 0 || y < min_y)
+            min_y = y;
+        if (i == 0 || y > max_y)
+            max_y = y;
+    }
+    /* Far off-screen corners are pulled in so they convert to int */
+    const double limit = 1 << 30;
+    m->bounds.x0 = (int)floor(min_x < -limit ? -limit : min_x);
+    m->bounds.y0 = (int)floor(min_y < -limit ? -limit : min_y);
+    m->bounds.x1 = (int)ceil(max_x > limit ? limit : max_x);
+    m->bounds.y1 = (int)ceil(max_y > limit ? limit : max_y);
+    return m->bounds.x0 < m->bounds.x1 && m->bounds.y0 < m->bounds.y1;
+}
+
+static void affine_span_limits(double start, double step, double limit, int *lo, int *hi)
+{
+    /* Narrows [*lo, *hi) to the pixels i with 0 <= start + i * step < limit */
+    double first = *lo, last = *hi;
+    if (step > 0.0)
+    {
+        first = fmax(first, ceil(-start / step));
+        last = fmin(last, ceil((limit - start) / step));
+    }
+    else if (step < 0.0)
+    {
+        first = fmax(first, floor((limit - start) / step) + 1.0);
+        last = fmin(last, floor(-start / step) + 1.0);
+    }
+    else if (start < 0.0 || start >= limit)
+    {
+        last = first;
+    }
+    /* Non-empty results lie within the original range, so they convert safely */
+    if (last <= first)
+    {
+        *hi = *lo;
+        return;
+    }
+    *lo = (int)first;
+    *hi = (int)last;
+}
+
+static void draw_affine_sprite(ArcadeContext *ctx, const ArcadeAffineSprite *s, int x0, int y0, int x1, int y1)
+{
+    /* Inverse-mapped scanlines: each row is cut down to the pixels whose source
+     * position lies inside the image, then sampled in chunks and blended */
+    ArcadeAffineMap m;
+    if (!affine_map(s, &m))
+        return;
+    int bilinear = s->filter == ARCADE_FILTER_BILINEAR;
+    double margin = bilinear ? 0.5 : 0.0;
+    ArcadeAffineSpan span = {.pixels = s->image.pixels, .stride = s->image.stride ? s->image.stride : s->image.image_width,
+                             .width = m.width, .height = m.height};
+    uint32_t samples[256];
+    for (int y = y0; y < y1; y++)
+    {
+        /* Source position at the center of pixel (0, y); bilinear taps start half a pixel earlier */
+        double row_u = m.ax + (y + 0.5) * m.yx + 0.5 * m.xx - margin;
+        double row_v = m.ay + (y + 0.5) * m.yy + 0.5 * m.xy - margin;
+        int lo = x0, hi = x1;
+        affine_span_limits(row_u + 2.0 * margin, m.xx, m.width + 2.0 * margin, &lo, &hi);
+        affine_span_limits(row_v + 2.0 * margin, m.xy, m.height + 2.0 * margin, &lo, &hi);
+        uint32_t *dst = ctx->state.pixels + y * ctx->state.width;
+        for (int x = lo; x < hi; x += 256)
+        {
+            int count = hi - x < 256 ? hi - x : 256;
+            span.u = (int32_t)floor((row_u + x * m.xx) * 65536.0);
+            span.v = (int32_t)floor((row_v + x * m.xy) * 65536.0);
+            span.du = (int32_t)lrint(m.xx * 65536.0);
+            span.dv = (int32_t)lrint(m.xy * 65536.0);
+            if (bilinear)
+                kernels.sample_bilinear(samples, &span, count);
+            else
+                kernels.sample_nearest(samples, &span, count);
+            kernels.blend(dst + x, samples, count);
+        }
+    }
+}
+
+static int sprite_bounds(const ArcadeAnySprite *sprite, int type, ArcadeRegion *out)
+{
+    /* Pixel rectangle a sprite covers, using the same rounding as draw_sprite */
+    int x_start, y_start, w, h;
+    if (type == SPRITE_COLOR && sprite->sprite.active)
+    {
+        const ArcadeSprite *s = &sprite->sprite;
+        x_start = (int)s->x;
+        y_start = (int)s->y;
+        w = (int)s->width;
+        h = (int)s->height;
+    }
+    else if (type == SPRITE_IMAGE && sprite->image_sprite.active && sprite->image_sprite.pixels)
+    {
+        const ArcadeImageSprite *s = &sprite->image_sprite;
+        x_start = (int)s->x;
+        y_start = (int)s->y;
+        /* Quarter turns swap the image's on-screen dimensions */
+        int turned = s->orientation & ARCADE_ORIENT_ROTATE_90;
+        int image_w = turned ? s->image_height : s->image_width;
+        int image_h = turned ? s->image_width : s->image_height;
+        w = (int)s->width < image_w ? (int)s->width : image_w;
+        h = (int)s->height < image_h ? (int)s->height : image_h;
+    }
+    else if (type == SPRITE_AFFINE)
+    {
+        ArcadeAffineMap m;
+        if (!affine_map(&sprite->affine_sprite, &m))
+            return 0;
+        *out = m.bounds;
+        return 1;
+    }
+    else
+    {
+        return 0;
+    }
+    if (w <= 0 || h <= 0)
+        return 0;
+    out->x0 = x_start;
+    out->y0 = y_start;
+    out->x1 = x_start + w;
+    out->y1 = y_start + h;
+    return 1;
+}
+
+static int image_unchanged(const ArcadeImageSprite *p, const ArcadeImageSprite *q)
+{
+    return p->x == q->x && p->y == q->y && p->width == q->width && p->height == q->height && p->pixels == q->pixels &&
+           p->image_width == q->image_width && p->image_height == q->image_height && p->active == q->active &&
+           p->orientation == q->orientation;
+}
+
+static int sprite_unchanged(const ArcadeAnySprite *a, const ArcadeAnySprite *b, int type)
+{
+    /* Compares only the fields that affect what is drawn (velocity is ignored) */
+    if (type == SPRITE_COLOR)
+    {
+        const ArcadeSprite *p = &a->sprite, *q = &b->sprite;
+        return p->x == q->x && p->y == q->y && p->width == q->width && p->height == q->height &&
+               p->color == q->color && p->active == q->active;
+    }
+    if (type == SPRITE_IMAGE)
+        return image_unchanged(&a->image_sprite, &b->image_sprite);
+    if (type == SPRITE_AFFINE)
+    {
+        const ArcadeAffineSprite *p = &a->affine_sprite, *q = &b->affine_sprite;
+        return image_unchanged(&p->image, &q->image) && p->scale_x == q->scale_x && p->scale_y == q->scale_y &&
+               p->angle == q->angle && p->origin_x == q->origin_x && p->origin_y == q->origin_y && p->filter == q->filter;
+    }
+    return 1;
+}
+
+static int region_area(const ArcadeRegion *r)
+{
+    return (r->x1 - r->x0) * (r->y1 - r->y0);
+}
+
+static ArcadeRegion region_union(const ArcadeRegion *a, const ArcadeRegion *b)
+{
+    ArcadeRegion u;
+    u.x0 = a->x0 < b->x0 ? a->x0 : b->x0;
+    u.y0 = a->y0 < b->y0 ? a->y0 : b->y0;
+    u.x1 = a->x1 > b->x1 ? a->x1 : b->x1;
+    u.y1 = a->y1 > b->y1 ? a->y1 : b->y1;
+    return u;
+}
+
+static void add_dirty_rect(ArcadeContext *ctx, ArcadeRegion r)
+{
+    /* Clip to the window; off-screen movement leaves nothing to repaint */
+    if (r.x0 < 0)
+        r.x0 = 0;
+    if (r.y0 < 0)
+        r.y0 = 0;
+    if (r.x1 > ctx->state.width)
+        r.x1 = ctx->state.width;
+    if (r.y1 > ctx->state.height)
+        r.y1 = ctx->state.height;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1)
+        return;
+
+    /* Absorb every rect that overlaps or touches; the union may reach further ones */
+    int i = 0;
+    while (i < ctx->dirty_count)
+    {
+        ArcadeRegion *d = &ctx->dirty[i];
+        if (d->x0 <= r.x1 && r.x0 <= d->x1 && d->y0 <= r.y1 && r.y0 <= d->y1)
+        {
+            r = region_union(d, &r);
+            ctx->dirty[i] = ctx->dirty[--ctx->dirty_count];
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    /* List is full: merge with the rect whose bounds grow the least */
+    if (ctx->dirty_count == ARCADE_MAX_DIRTY_RECTS)
+    {
+        int best = 0, best_growth = 0;
+        for (i = 0; i < ctx->dirty_count; i++)
+        {
+            ArcadeRegion u = region_union(&ctx->dirty[i], &r);
+            int growth = region_area(&u) - region_area(&ctx->dirty[i]);
+            if (i == 0 || growth < best_growth)
+            {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        r = region_union(&ctx->dirty[best], &r);
+        ctx->dirty[best] = ctx->dirty[--ctx->dirty_count];
+        add_dirty_rect(ctx, r);
+        return;
+    }
+    ctx->dirty[ctx->dirty_count++] = r;
+}
+
+static int collect_dirty_rects(ArcadeContext *ctx, ArcadeAnySprite *sprites, int count, int *types)
+{
+    /* Returns 1 if the whole frame must be redrawn instead */
+    ctx->dirty_count = 0;
+    if (ctx->full_redraw)
+        return 1;
+    int n = count > ctx->prev_count ? count : ctx->prev_count;
+    for (int i = 0; i < n; i++)
+    {
+        ArcadeRegion r;
+        int same = i < count && i < ctx->prev_count && types[i] == ctx->prev_types[i] &&
+                   sprite_unchanged(&sprites[i], &ctx->prev_sprites[i], types[i]);
+        if (same)
+            continue;
+        /* Repaint both where the sprite was and where it is now */
+        if (i < ctx->prev_count && sprite_bounds(&ctx->prev_sprites[i], ctx->prev_types[i], &r))
+            add_dirty_rect(ctx, r);
+        if (i < count && sprite_bounds(&sprites[i], types[i], &r))
+            add_dirty_rect(ctx, r);
+    }
+
+    /* Past half the window, one full-frame pass is cheaper than many small ones */
+    int area = 0;
+    for (int i = 0; i < ctx->dirty_count; i++)
+        area += region_area(&ctx->dirty[i]);
+    return area * 2 > ctx->state.width * ctx->state.height;
+}
+
+static void remember_sprites(ArcadeContext *ctx, ArcadeAnySprite *sprites, int count, int *types)
+{
+    if (count > ctx->prev_capacity)
+    {
+        ArcadeAnySprite *grown_sprites = realloc(ctx->prev_sprites, count * sizeof(ArcadeAnySprite));
+        if (grown_sprites)
+            ctx->prev_sprites = grown_sprites;
+        int *grown_types = realloc(ctx->prev_types, count * sizeof(int));
+        if (grown_types)
+            ctx->prev_types = grown_types;
+        if (!grown_sprites || !grown_types)
+        {
+            /* Without a record of this frame the next one cannot be diffed */
+            ctx->prev_count = 0;
+            ctx->full_redraw = 1;
+            return;
+        }
+        ctx->prev_capacity = count;
+    }
+    if (count > 0)
+    {
+        memcpy(ctx->prev_sprites, sprites, count * sizeof(ArcadeAnySprite));
+        memcpy(ctx->prev_types, types, count * sizeof(int));
+    }
+    ctx->prev_count = count;
+    ctx->full_redraw = 0;
+}
+
+static void orientation_map(const ArcadeImageSprite *s, int *origin_x, int *origin_y, int *step_ux, int *step_uy,
+                            int *step_vx, int *step_vy)
+{
+    /* The source pixel under offset (u, v) from the sprite's top-left on screen is
+     * (ox + u*ux + v*vx, oy + u*uy + v*vy) */
+    int iw = s->image_width, ih = s->image_height;
+    int ox = 0, oy = 0, ux = 1, uy = 0, vx = 0, vy = 1;
+    switch ((s->orientation >> 2) & 3)
+    {
+    case 1: /* 90 clockwise: screen rows run up the source columns */
+        oy = ih - 1;
+        ux = 0;
+        uy = -1;
+        vx = 1;
+        vy = 0;
+        break;
+    case 2:
+        ox = iw - 1;
+        oy = ih - 1;
+        ux = -1;
+        vy = -1;
+        break;
+    case 3: /* 270 clockwise: screen rows run down the source columns */
+        ox = iw - 1;
+        ux = 0;
+        uy = 1;
+        vx = -1;
+        vy = 0;
+        break;
+    }
+    if (s->orientation & ARCADE_ORIENT_FLIP_H)
+    {
+        ox = iw - 1 - ox;
+        ux = -ux;
+        vx = -vx;
+    }
+    if (s->orientation & ARCADE_ORIENT_FLIP_V)
+    {
+        oy = ih - 1 - oy;
+        uy = -uy;
+        vy = -vy;
+    }
+    *origin_x = ox;
+    *origin_y = oy;
+    *step_ux = ux;
+    *step_uy = uy;
+    *step_vx = vx;
+    *step_vy = vy;
+}
+
+static void draw_oriented_sprite(ArcadeContext *ctx, const ArcadeImageSprite *s, const ArcadeRegion *r, int x0, int y0,
+                                 int x1, int y1)
+{
+    /* Each visible span is gathered along the source direction its screen row
+     * maps to into a buffer, then copied or blended like an upright row */
+    int stride = s->stride ? s->stride : s->image_width;
+    int ox, oy, ux, uy, vx, vy;
+    orientation_map(s, &ox, &oy, &ux, &uy, &vx, &vy);
+    ptrdiff_t step = ux + (ptrdiff_t)uy * stride;
+    uint32_t span[256];
+    for (int y = y0; y < y1; y++)
+    {
+        int v = y - r->y0;
+        for (int x = x0; x < x1; x += 256)
+        {
+            int count = x1 - x < 256 ? x1 - x : 256;
+            int u = x - r->x0;
+            int sx = ox + u * ux + v * vx, sy = oy + u * uy + v * vy;
+            const uint32_t *src = s->pixels + (ptrdiff_t)sy * stride + sx;
+            uint32_t *dst = ctx->state.pixels + y * ctx->state.width + x;
+            if (step == -1)
+            {
+                kernels.reverse(span, src - (count - 1), count);
+                src = span;
+            }
+            else if (step != 1)
+            {
+                for (int i = 0; i < count; i++)
+                    span[i] = src[i * step];
+                src = span;
+            }
+            /* Only horizontal spans stay within one source row */
+            if (uy == 0 && s->opaque_rows && s->opaque_rows[sy])
+                memcpy(dst, src, count * sizeof(uint32_t));
+            else
+                kernels.blend(dst, src, count);
+        }
+    }
+}
+
+static void draw_sprite(ArcadeContext *ctx, ArcadeAnySprite *sprite, int type, const ArcadeRegion *clip)
+{
+    if (!sprite)
+        return;
+    ArcadeRegion r;
+    if (!sprite_bounds(sprite, type, &r))
+        return;
+    /* Clip first: restrict drawing to the part of the sprite inside the clip region,
+     * so the loops below only ever touch visible pixels */
+    int x0 = r.x0 > clip->x0 ? r.x0 : clip->x0;
+    int y0 = r.y0 > clip->y0 ? r.y0 : clip->y0;
+    int x1 = r.x1 < clip->x1 ? r.x1 : clip->x1;
+    int y1 = r.y1 < clip->y1 ? r.y1 : clip->y1;
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    if (type == SPRITE_COLOR)
+    {
+        /* Draw a solid rectangle for color-based sprites */
+        fill_region(ctx, x0, y0, x1, y1, sprite->sprite.color);
+    }
+    else if (type == SPRITE_AFFINE)
+    {
+        draw_affine_sprite(ctx, &sprite->affine_sprite, x0, y0, x1, y1);
+    }
+    else
+    {
+        ArcadeImageSprite *s = &sprite->image_sprite;
+        if (s->orientation)
+        {
+            draw_oriented_sprite(ctx, s, &r, x0, y0, x1, y1);
+            return;
+        }
+        int stride = s->stride ? s->stride : s->image_width;
+        size_t span_bytes = (size_t)(x1 - x0) * sizeof(uint32_t);
+        /* Draw image-based sprite one visible row span at a time: opaque rows are
+         * plain copies, the rest go through source-over alpha blending */
+        for (int y = y0; y < y1; y++)
+        {
+            int sy = y - r.y0;
+            const uint32_t *src = s->pixels + sy * stride + (x0 - r.x0);
+            uint32_t *dst = ctx->state.pixels + y * ctx->state.width + x0;
+            if (s->opaque_rows && s->opaque_rows[sy])
+                memcpy(dst, src, span_bytes);
+            else
+                kernels.blend(dst, src, x1 - x0);
+        }
+    }
+}
+
+/* =========================================================================
+ * Tile Renderer
+ * Opt-in parallel path for arcade_render_scene: sprites are binned into
+ * ARCADE_TILE_SIZE squares and a fixed worker pool rasterizes whole tiles.
+ * Each tile is owned by one thread, and its bin lists sprites in array order,
+ * so the painter's order of sprites[] is preserved.
+ * ========================================================================= */
+static int tile_range(const ArcadeRenderPool *pool, const ArcadeAnySprite *sprite, int type, ArcadeRegion *out)
+{
+    /* Tiles covered by the on-screen part of a sprite, as a half-open range */
+    ArcadeRegion r;
+    if (!sprite_bounds(sprite, type, &r))
+        return 0;
+    int w = pool->ctx->state.width, h = pool->ctx->state.height;
+    if (r.x0 < 0) r.x0 = 0;
+    if (r.y0 < 0) r.y0 = 0;
+    if (r.x1 > w) r.x1 = w;
+    if (r.y1 > h) r.y1 = h;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1)
+        return 0;
+    out->x0 = r.x0 / ARCADE_TILE_SIZE;
+    out->y0 = r.y0 / ARCADE_TILE_SIZE;
+    out->x1 = (r.x1 - 1) / ARCADE_TILE_SIZE + 1;
+    out->y1 = (r.y1 - 1) / ARCADE_TILE_SIZE + 1;
+    return 1;
+}
+
+static int bin_sprites(ArcadeRenderPool *pool, ArcadeAnySprite *sprites, int count, int *types)
+{
+    /* Counting sort of (tile, sprite) pairs; sprites are visited in order so
+     * every bin ends up sorted by sprite index */
+    int tile_count = pool->tiles_x * pool->tiles_y;
+    if (tile_count + 1 > pool->tile_capacity)
+    {
+        int *bin_start = realloc(pool->bin_start, (tile_count + 1) * sizeof(int));
+        if (!bin_start)
+            return 1;
+        pool->bin_start = bin_start;
+        pool->tile_capacity = tile_count + 1;
+    }
+    memset(pool->bin_start, 0, (tile_count + 1) * sizeof(int));
+    ArcadeRegion t;
+    for (int i = 0; i < count; i++)
+    {
+        if (!tile_range(pool, &sprites[i], types[i], &t))
+            continue;
+        for (int ty = t.y0; ty < t.y1; ty++)
+            for (int tx = t.x0; tx < t.x1; tx++)
+                pool->bin_start[ty * pool->tiles_x + tx + 1]++;
+    }
+    for (int i = 0; i < tile_count; i++)
+        pool->bin_start[i + 1] += pool->bin_start[i];
+    int item_count = pool->bin_start[tile_count];
+    if (item_count > pool->item_capacity)
+    {
+        int *bin_items = realloc(pool->bin_items, item_count * sizeof(int));
+        if (!bin_items)
+            return 1;
+        pool->bin_items = bin_items;
+        pool->item_capacity = item_count;
+    }
+    /* Scatter, advancing each bin's start to its end, then shift the starts back */
+    for (int i = 0; i < count; i++)
+    {
+        if (!tile_range(pool, &sprites[i], types[i], &t))
+            continue;
+        for (int ty = t.y0; ty < t.y1; ty++)
+            for (int tx = t.x0; tx < t.x1; tx++)
+                pool->bin_items[pool->bin_start[ty * pool->tiles_x + tx]++] = i;
+    }
+    memmove(pool->bin_start + 1, pool->bin_start, tile_count * sizeof(int));
+    pool->bin_start[0] = 0;
+    return 0;
+}
+
+static void render_tile(ArcadeRenderPool *pool, int tile)
+{
+    ArcadeContext *ctx = pool->ctx;
+    int tx = tile % pool->tiles_x, ty = tile / pool->tiles_x;
+    ArcadeRegion bounds = {tx * ARCADE_TILE_SIZE, ty * ARCADE_TILE_SIZE,
+                           (tx + 1) * ARCADE_TILE_SIZE, (ty + 1) * ARCADE_TILE_SIZE};
+    if (bounds.x1 > ctx->state.width)
+        bounds.x1 = ctx->state.width;
+    if (bounds.y1 > ctx->state.height)
+        bounds.y1 = ctx->state.height;
+    for (int r = 0; r < pool->region_count; r++)
+    {
+        const ArcadeRegion *region = &pool->regions[r];
+        ArcadeRegion clip = {
+            region->x0 > bounds.x0 ? region->x0 : bounds.x0, region->y0 > bounds.y0 ? region->y0 : bounds.y0,
+            region->x1 < bounds.x1 ? region->x1 : bounds.x1, region->y1 < bounds.y1 ? region->y1 : bounds.y1};
+        if (clip.x0 >= clip.x1 || clip.y0 >= clip.y1)
+            continue;
+        fill_region(ctx, clip.x0, clip.y0, clip.x1, clip.y1, ctx->state.bg_color);
+        for (int k = pool->bin_start[tile]; k < pool->bin_start[tile + 1]; k++)
+        {
+            int i = pool->bin_items[k];
+            draw_sprite(ctx, &pool->sprites[i], pool->types[i], &clip);
+        }
+    }
+}
+
+static void run_tiles(ArcadeRenderPool *pool)
+{
+    /* Claim tiles one at a time until none are left */
+    int tile_count = pool->tiles_x * pool->tiles_y;
+    int tile;
+    while ((tile = atomic_fetch_add_int(&pool->next_tile, 1)) < tile_count)
+        render_tile(pool, tile);
+}
+
+ARCADE_THREAD_FUNC(render_worker)
+{
+    ArcadeRenderPool *pool = (ArcadeRenderPool *)arg;
+    int seen = 0;
+    for (;;)
+    {
+        mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen)
+            cond_wait(&pool->work_ready, &pool->lock);
+        if (pool->shutdown)
+        {
+            mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        mutex_unlock(&pool->lock);
+
+        run_tiles(pool);
+
+        mutex_lock(&pool->lock);
+        if (--pool->busy == 0)
+            cond_broadcast(&pool->work_done);
+        mutex_unlock(&pool->lock);
+    }
+    ARCADE_THREAD_RETURN;
+}
+
+static int render_tiles(ArcadeContext *ctx, ArcadeAnySprite *sprites, int count, int *types,
+                        const ArcadeRegion *regions, int region_count)
+{
+    ArcadeRenderPool *pool = ctx->render_pool;
+    pool->tiles_x = (ctx->state.width + ARCADE_TILE_SIZE - 1) / ARCADE_TILE_SIZE;
+    pool->tiles_y = (ctx->state.height + ARCADE_TILE_SIZE - 1) / ARCADE_TILE_SIZE;
+    if (bin_sprites(pool, sprites, count, types) != 0)
+        return 1; /* Out of memory; caller renders on this thread instead */
+    pool->sprites = sprites;
+    pool->types = types;
+    pool->regions = regions;
+    pool->region_count = region_count;
+    pool->next_tile = 0;
+
+    /* Publish the frame, render alongside the workers, then wait for them */
+    mutex_lock(&pool->lock);
+    pool->busy = pool->thread_count;
+    pool->generation++;
+    cond_broadcast(&pool->work_ready);
+    mutex_unlock(&pool->lock);
+    run_tiles(pool);
+    mutex_lock(&pool->lock);
+    while (pool->busy > 0)
+        cond_wait(&pool->work_done, &pool->lock);
+    mutex_unlock(&pool->lock);
+    return 0;
+}
+
+static void present_regions(ArcadeContext *ctx, const ArcadeRegion *regions, int region_count)
+{
+#ifdef _WIN32
+    HDC memDC = CreateCompatibleDC(ctx->state.hdc);
+    SelectObject(memDC, ctx->state.hbitmap);
+    for (int i = 0; i < region_count; i++)
+    {
+        const ArcadeRegion *r = &regions[i];
+        BitBlt(ctx->state.hdc, r->x0, r->y0, r->x1 - r->x0, r->y1 - r->y0, memDC, r->x0, r->y0, SRCCOPY);
+    }
+    DeleteDC(memDC);
+#else
+    for (int i = 0; i < region_count; i++)
+    {
+        const ArcadeRegion *r = &regions[i];
+#ifndef ARCADE_NO_XSHM
+        if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
+        {
+            /* Zero-copy: the server reads the shared segment. Only the last request
+             * asks for a completion event, which implies all earlier ones are done. */
+            XShmPutImage(ctx->state.display, ctx->state.window, ctx->state.gc, ctx->state.image,
+                         r->x0, r->y0, r->x0, r->y0, r->x1 - r->x0, r->y1 - r->y0, i == region_count - 1);
+            if (i == region_count - 1)
+                ctx->state.shm_pending++;
+        }
+        else
+#endif
+            XPutImage(ctx->state.display, ctx->state.window, ctx->state.gc, ctx->state.image,
+                      r->x0, r->y0, r->x0, r->y0, r->x1 - r->x0, r->y1 - r->y0);
+    }
+#ifndef ARCADE_NO_XSHM
+    if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
+        XFlush(ctx->state.display);
+#endif
+#endif
+}
+
+void arcade_ctx_set_dirty_tracking(ArcadeContext *ctx, int enabled)
+{
+    ctx->dirty_tracking = enabled ? 1 : 0;
+    ctx->full_redraw = 1;
+    ctx->prev_count = 0;
+}
+
+void arcade_set_dirty_tracking(int enabled)
+{
+    arcade_ctx_set_dirty_tracking(&default_context, enabled);
+}
+
+int arcade_ctx_set_render_threads(ArcadeContext *ctx, int threads)
+{
+    destroy_render_pool(ctx);
+    if (threads <= 1)
+        return 0; /* Render on the calling thread */
+    if (threads > ARCADE_MAX_RENDER_THREADS)
+        threads = ARCADE_MAX_RENDER_THREADS;
+    ArcadeRenderPool *pool = calloc(1, sizeof(ArcadeRenderPool));
+    if (!pool)
+        return 1;
+    pool->threads = malloc((threads - 1) * sizeof(ArcadeThread));
+    if (!pool->threads)
+    {
+        free(pool);
+        return 1;
+    }
+    pool->ctx = ctx;
+    mutex_init(&pool->lock);
+    cond_init(&pool->work_ready);
+    cond_init(&pool->work_done);
+    ctx->render_pool = pool;
+    /* The calling thread renders too, so start threads - 1 workers */
+    for (int i = 0; i < threads - 1; i++)
+    {
+        if (thread_start(&pool->threads[i], render_worker, pool) != 0)
+            break;
+        pool->thread_count++;
+    }
+    if (pool->thread_count < threads - 1)
+    {
+        fprintf(stderr, "Cannot start render threads\n");
+        destroy_render_pool(ctx);
+        return 1;
+    }
+    return 0;
+}
+
+int arcade_set_render_threads(int threads)
+{
+    return arcade_ctx_set_render_threads(&default_context, threads);
+}
+
+void arcade_ctx_invalidate(ArcadeContext *ctx)
+{
+    ctx->full_redraw = 1;
+}
+
+void arcade_invalidate(void)
+{
+    arcade_ctx_invalidate(&default_context);
+}
+
+int arcade_ctx_present_mode(ArcadeContext *ctx)
+{
+    if (ctx->state.headless)
+        return ARCADE_PRESENT_NONE;
+#ifdef _WIN32
+    return ARCADE_PRESENT_BLIT;
+#else
+    return ctx->state.present_mode;
+#endif
+}
+
+int arcade_present_mode(void)
+{
+    return arcade_ctx_present_mode(&default_context);
+}
+
+/* 8x8 glyphs for ASCII 32-126 (public domain font8x8_basic); bit 0 is the leftmost pixel */
+static const uint8_t font8x8[95][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* space */
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, /* ! */
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* " */
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, /* # */
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, /* $ */
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, /* % */
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, /* & */
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, /* apostrophe */
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, /* ( */
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, /* ) */
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, /* asterisk */
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, /* + */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, /* , */
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, /* - */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, /* . */
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, /* slash */
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, /* 0 */
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, /* 1 */
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, /* 2 */
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, /* 3 */
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, /* 4 */
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, /* 5 */
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, /* 6 */
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, /* 7 */
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, /* 8 */
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, /* 9 */
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, /* : */
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, /* ; */
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, /* < */
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, /* = */
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, /* > */
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, /* ? */
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, /* @ */
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, /* A */
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, /* B */
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, /* C */
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, /* D */
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, /* E */
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, /* F */
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, /* G */
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, /* H */
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* I */
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, /* J */
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, /* K */
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, /* L */
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, /* M */
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, /* N */
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, /* O */
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, /* P */
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, /* Q */
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, /* R */
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, /* S */
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* T */
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, /* U */
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, /* V */
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, /* W */
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, /* X */
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, /* Y */
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, /* Z */
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, /* [ */
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, /* backslash */
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, /* ] */
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, /* ^ */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, /* _ */
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, /* ` */
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, /* a */
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, /* b */
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, /* c */
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, /* d */
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, /* e */
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, /* f */
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, /* g */
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, /* h */
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* i */
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, /* j */
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, /* k */
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* l */
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, /* m */
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, /* n */
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, /* o */
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, /* p */
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, /* q */
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, /* r */
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, /* s */
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, /* t */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, /* u */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, /* v */
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, /* w */
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, /* x */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, /* y */
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, /* z */
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, /* { */
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, /* | */
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, /* } */
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* ~ */
+};
+
+static uint32_t hash_text(const char *text)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (; *text; text++)
+        hash = (hash ^ (unsigned char)*text) * 16777619u;
+    return hash;
+}
+
+static const uint8_t *glyph_for(char c)
+{
+    unsigned char ch = (unsigned char)c;
+    return font8x8[(ch < 32 || ch > 126) ? '?' - 32 : ch - 32];
+}
+
+static int build_text_runs(const char *text, int length, ArcadeTextRun *runs)
+{
+    /* Scans every glyph row across the whole string, so runs continue across
+     * neighbouring characters. Returns the run count; runs may be NULL to count. */
+    int count = 0;
+    int width = length * ARCADE_GLYPH_WIDTH;
+    for (int row = 0; row < 8; row++)
+    {
+        int start = -1;
+        for (int x = 0; x <= width; x++)
+        {
+            int lit = x < width && ((glyph_for(text[x / ARCADE_GLYPH_WIDTH])[row] >> (x % ARCADE_GLYPH_WIDTH)) & 1);
+            if (lit && start < 0)
+                start = x;
+            else if (!lit && start >= 0)
+            {
+                if (runs)
+                    runs[count] = (ArcadeTextRun){start, row, x - start};
+                count++;
+                start = -1;
+            }
+        }
+    }
+    return count;
+}
+
+static ArcadeTextLayout *layout_text(ArcadeContext *ctx, const char *text)
+{
+    /* Returns the cached layout for text, rasterizing it into runs on a miss */
+    uint32_t hash = hash_text(text);
+    ArcadeTextLayout *victim = &ctx->text_cache[0];
+    ctx->text_clock++;
+    for (int i = 0; i < ARCADE_TEXT_CACHE_SIZE; i++)
+    {
+        ArcadeTextLayout *layout = &ctx->text_cache[i];
+        if (layout->text && layout->hash == hash && strcmp(layout->text, text) == 0)
+        {
+            layout->used = ctx->text_clock;
+            return layout;
+        }
+        /* Prefer an empty slot, otherwise evict the least recently used layout */
+        if (victim->text && (!layout->text || layout->used < victim->used))
+            victim = layout;
+    }
+
+    int length = (int)strlen(text);
+    int run_count = build_text_runs(text, length, NULL);
+    char *copy = malloc(length + 1);
+    ArcadeTextRun *runs = malloc((run_count ? run_count : 1) * sizeof(ArcadeTextRun));
+    if (!copy || !runs)
+    {
+        free(copy);
+        free(runs);
+        return NULL;
+    }
+    memcpy(copy, text, length + 1);
+    build_text_runs(text, length, runs);
+    free(victim->text);
+    free(victim->runs);
+    victim->text = copy;
+    victim->hash = hash;
+    victim->width = length * ARCADE_GLYPH_WIDTH;
+    victim->runs = runs;
+    victim->run_count = run_count;
+    victim->used = ctx->text_clock;
+    return victim;
+}
+
+static int text_bounds(const ArcadeContext *ctx, const ArcadeTextItem *item, ArcadeRegion *out)
+{
+    /* On-screen rectangle of a queued string; 0 if none of it is visible */
+    ArcadeRegion r = {item->x, item->y, item->x + item->width, item->y + ARCADE_GLYPH_HEIGHT};
+    if (r.x0 < 0) r.x0 = 0;
+    if (r.y0 < 0) r.y0 = 0;
+    if (r.x1 > ctx->state.width) r.x1 = ctx->state.width;
+    if (r.y1 > ctx->state.height) r.y1 = ctx->state.height;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1)
+        return 0;
+    *out = r;
+    return 1;
+}
+
+static void draw_text(ArcadeContext *ctx, const ArcadeTextLayout *layout, const ArcadeTextItem *item)
+{
+    ArcadeRegion clip;
+    if (!text_bounds(ctx, item, &clip))
+        return;
+    int scale = ARCADE_GLYPH_HEIGHT / 8;
+    for (int i = 0; i < layout->run_count; i++)
+    {
+        const ArcadeTextRun *run = &layout->runs[i];
+        int x0 = item->x + run->x, x1 = x0 + run->length;
+        if (x0 < clip.x0) x0 = clip.x0;
+        if (x1 > clip.x1) x1 = clip.x1;
+        if (x0 >= x1)
+            continue;
+        for (int dy = 0; dy < scale; dy++)
+        {
+            int py = item->y + run->y * scale + dy;
+            if (py >= clip.y0 && py < clip.y1)
+                kernels.fill(ctx->state.pixels + py * ctx->state.width + x0, x1 - x0, item->color);
+        }
+    }
+}
+
+static void queue_text(ArcadeContext *ctx, const char *text, int x, int y, uint32_t color)
+{
+    ArcadeTextQueue *queue = &ctx->text_queue;
+    size_t length = strlen(text);
+    if (queue->count == queue->capacity)
+    {
+        int new_capacity = queue->capacity ? queue->capacity * 2 : 16;
+        ArcadeTextItem *grown = realloc(queue->items, new_capacity * sizeof(ArcadeTextItem));
+        if (!grown)
+        {
+            fprintf(stderr, "arcade_render_text: Skipping (out of memory)\n");
+            return;
+        }
+        queue->items = grown;
+        queue->capacity = new_capacity;
+    }
+    if (queue->used + length + 1 > queue->size)
+    {
+        size_t new_size = queue->size ? queue->size * 2 : 256;
+        while (new_size < queue->used + length + 1)
+            new_size *= 2;
+        char *grown = realloc(queue->chars, new_size);
+        if (!grown)
+        {
+            fprintf(stderr, "arcade_render_text: Skipping (out of memory)\n");
+            return;
+        }
+        queue->chars = grown;
+        queue->size = new_size;
+    }
+    memcpy(queue->chars + queue->used, text, length + 1);
+    queue->items[queue->count++] = (ArcadeTextItem){.text = queue->used, .x = x, .y = y,
+                                                    .width = (int)length * ARCADE_GLYPH_WIDTH, .color = color};
+    queue->used += length + 1;
+}
+
+static int same_text_item(const ArcadeTextQueue *a, const ArcadeTextItem *p, const ArcadeTextQueue *b,
+                          const ArcadeTextItem *q)
+{
+    return p->x == q->x && p->y == q->y && p->width == q->width && p->color == q->color &&
+           strcmp(a->chars + p->text, b->chars + q->text) == 0;
+}
+
+static void add_text_dirty_rects(ArcadeContext *ctx)
+{
+    /* Repaint under text that changed, moved or went away since the last frame.
+     * Text drawn again unchanged is left alone: redrawing it over itself is a no-op */
+    const ArcadeTextQueue *now = &ctx->text_queue, *last = &ctx->text_shown;
+    int n = now->count > last->count ? now->count : last->count;
+    ArcadeRegion r;
+    for (int i = 0; i < n; i++)
+    {
+        if (i < now->count && i < last->count && same_text_item(now, &now->items[i], last, &last->items[i]))
+            continue;
+        if (i < last->count && text_bounds(ctx, &last->items[i], &r))
+            add_dirty_rect(ctx, r);
+        if (i < now->count && text_bounds(ctx, &now->items[i], &r))
+            add_dirty_rect(ctx, r);
+    }
+}
+
+static void draw_queued_text(ArcadeContext *ctx)
+{
+    /* Draws the text queued since the last render, then keeps it for the next diff */
+    ArcadeTextQueue *queue = &ctx->text_queue;
+    for (int i = 0; i < queue->count; i++)
+    {
+        ArcadeTextLayout *layout = layout_text(ctx, queue->chars + queue->items[i].text);
+        if (!layout)
+        {
+            fprintf(stderr, "arcade_render_text: Skipping (out of memory)\n");
+            continue;
+        }
+        draw_text(ctx, layout, &queue->items[i]);
+    }
+    ArcadeTextQueue shown = ctx->text_shown;
+    ctx->text_shown = *queue;
+    *queue = shown;
+    queue->count = 0;
+    queue->used = 0;
+}
+
+void arcade_ctx_render_scene(ArcadeContext *ctx, ArcadeAnySprite *sprites, int count, int *types)
+{
+#if !defined(_WIN32) && !defined(ARCADE_NO_XSHM)
+    if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
+        wait_for_shm(ctx); /* Do not draw over pixels the server is still reading */
+#endif
+    ArcadeRegion full = {0, 0, ctx->state.width, ctx->state.height};
+    const ArcadeRegion *regions = &full;
+    int region_count = 1;
+    if (ctx->dirty_tracking)
+    {
+        /* Only repaint where sprites or text changed since the previous frame */
+        if (!collect_dirty_rects(ctx, sprites, count, types))
+        {
+            add_text_dirty_rects(ctx);
+            regions = ctx->dirty;
+            region_count = ctx->dirty_count;
+        }
+        remember_sprites(ctx, sprites, count, types);
+    }
+    if (!ctx->render_pool || region_count == 0 ||
+        render_tiles(ctx, sprites, count, types, regions, region_count) != 0)
+    {
+        for (int r = 0; r < region_count; r++)
+        {
+            const ArcadeRegion *region = &regions[r];
+            fill_region(ctx, region->x0, region->y0, region->x1, region->y1, ctx->state.bg_color);
+            for (int i = 0; i < count; i++)
+            {
+                draw_sprite(ctx, &sprites[i], types[i], region);
+            }
+        }
+    }
+    /* Text goes on top before presenting, so each frame is uploaded once, with its text */
+    draw_queued_text(ctx);
+    ctx->scene_rendered = 1;
+    if (ctx->state.headless || region_count == 0)
+        return; /* Nothing to present */
+    present_regions(ctx, regions, region_count);
+}
+
+void arcade_render_scene(ArcadeAnySprite *sprites, int count, int *types)
+{
+    arcade_ctx_render_scene(&default_context, sprites, count, types);
+}
+
+static void present_queued_text(ArcadeContext *ctx)
+{
+    /* Draws queued text over the last frame and uploads just its rectangles. Successive
+     * text-only frames pile up, so the next scene render repaints everything */
+#if !defined(_WIN32) && !defined(ARCADE_NO_XSHM)
+    if (ctx->state.present_mode == ARCADE_PRESENT_XSHM)
+        wait_for_shm(ctx);
+#endif
+    ctx->dirty_count = 0;
+    ArcadeRegion r;
+    for (int i = 0; i < ctx->text_queue.count; i++)
+        if (text_bounds(ctx, &ctx->text_queue.items[i], &r))
+            add_dirty_rect(ctx, r);
+    draw_queued_text(ctx);
+    ctx->full_redraw = 1;
+    if (!ctx->state.headless && ctx->dirty_count > 0)
+        present_regions(ctx, ctx->dirty, ctx->dirty_count);
+}
+
+void arcade_ctx_render_text(ArcadeContext *ctx, const char *text, float x, float y, unsigned int color)
+{
+    if (!text)
+        return;
+    queue_text(ctx, text, (int)x, (int)y, color);
+}
+
+void arcade_render_text(const char *text, float x, float y, unsigned int color)
+{
+    arcade_ctx_render_text(&default_context, text, x, y, color);
+}
+
+void arcade_ctx_render_text_centered(ArcadeContext *ctx, const char *text, float y, unsigned int color)
+{
+    if (!text)
+        return;
+    float x = (ctx->state.width - (float)strlen(text) * ARCADE_GLYPH_WIDTH) / 2.0f;
+    queue_text(ctx, text, (int)x, (int)y, color);
+}
+
+void arcade_render_text_centered(const char *text, float y, unsigned int color)
+{
+    arcade_ctx_render_text_centered(&default_context, text, y, color);
+}
+
+void arcade_ctx_render_text_centered_blink(ArcadeContext *ctx, const char *text, float y, unsigned int color, int blink_interval)
+{
+    if (!text)
+        return;
+    if ((ctx->frame_counter % (2 * blink_interval)) < blink_interval)
+    {
+        arcade_ctx_render_text_centered(ctx, text, y, color);
+    }
+}
+
+void arcade_render_text_centered_blink(const char *text, float y, unsigned int color, int blink_interval)
+{
+    arcade_ctx_render_text_centered_blink(&default_context, text, y, color, blink_interval);
+}
+
+/* =========================================================================
+ * Sprite Groups
+ * ========================================================================= */
+
+void arcade_init_group(SpriteGroup *group, int capacity)
+{
+    group->sprites = malloc(capacity * sizeof(ArcadeAnySprite));
+    group->types = malloc(capacity * sizeof(int));
+    group->count = 0;
+    group->capacity = capacity;
+}
+
+void arcade_add_sprite_to_group(SpriteGroup *group, ArcadeAnySprite sprite, int type)
+{
+    if (group->count < group->capacity)
+    {
+        group->sprites[group->count] = sprite;
+        group->types[group->count] = type;
+        group->count++;
+    }
+}
+
+void arcade_add_animated_to_group(SpriteGroup *group, ArcadeAnimatedSprite *anim)
+{
+    if (!anim || !anim->frames[0].active)
+        return;
+    arcade_add_sprite_to_group(group, (ArcadeAnySprite){.image_sprite = anim->frames[anim->current_frame]}, SPRITE_IMAGE);
+}
+
+void arcade_add_anim_instance_to_group(SpriteGroup *group, const ArcadeAnimInstance *instance)
+{
+    if (!instance || !instance->active || !instance->clip)
+        return;
+    arcade_add_sprite_to_group(group, (ArcadeAnySprite){.image_sprite = arcade_anim_instance_sprite(instance)}, SPRITE_IMAGE);
+}
+
+void arcade_ctx_render_group(ArcadeContext *ctx, SpriteGroup *group)
+{
+    arcade_ctx_render_scene(ctx, group->sprites, group->count, group->types);
+}
+
+void arcade_render_group(SpriteGroup *group)
+{
+    arcade_ctx_render_group(&default_context, group);
+}
+
+void arcade_free_group(SpriteGroup *group)
+{
+    free(group->sprites);
+    free(group->types);
+    group->count = 0;
+    group->capacity = 0;
+}
+
+/* =========================================================================
+ * Collision Broadphase
+ * A spatial hash rebuilt from a SpriteGroup each frame: every sprite is
+ * listed under each grid cell its box touches, grouped by hash slot with a
+ * counting sort, so overlap tests only run between sprites sharing a cell.
+ * ========================================================================= */
+#define ARCADE_HASH_MAX_CELLS 64 /* Sprites touching more cells are tested against everything instead */
+
+typedef struct
+{
+    float x0, y0, x1, y1;   /* Collision box; x0 >= x1 for sprites that never collide */
+    int cx0, cy0, cx1, cy1; /* Cells touched, inclusive */
+} ArcadeHashBox;
+
+typedef struct
+{
+    int sprite; /* Index into the group */
+    int cx, cy; /* Cell this entry lists the sprite under */
+} ArcadeHashItem;
+
+struct ArcadeSpatialHash
+{
+    float cell_size;            /* Requested cell size (0 = automatic) */
+    float inv_cell;             /* 1 / cell size used by the last build */
+    int count;                  /* Sprites in the last build */
+    ArcadeHashBox *boxes;       /* Per-sprite boxes and cell ranges */
+    int box_capacity;
+    unsigned *marks;            /* Per-sprite stamp, so a query reports each sprite once */
+    int mark_capacity;
+    unsigned mark;              /* Stamp of the current query */
+    int slot_mask;              /* Hash slot count - 1 */
+    int *slot_start;            /* Counting-sort offsets into items, slot_mask + 2 entries */
+    int slot_capacity;
+    ArcadeHashItem *items;      /* (sprite, cell) entries grouped by slot, sprites ascending */
+    int item_capacity;
+    int *large;                 /* Sprites covering more than ARCADE_HASH_MAX_CELLS cells */
+    int large_count, large_capacity;
+    ArcadeCollisionPair *pairs; /* Result of the last arcade_spatial_hash_pairs */
+    int pair_count, pair_capacity;
+    int *results;               /* Result of the last arcade_spatial_hash_query */
+    int result_count, result_capacity;
+};
+
+static int grow_buffer(void **buffer, int *capacity, int needed, size_t item_size)
+{
+    /* Doubles *buffer until it holds needed items; 1 on allocation failure */
+    if (needed <= *capacity)
+        return 0;
+    int grown = *capacity ? *capacity : 16;
+    while (grown < needed)
+        grown *= 2;
+    void *p = realloc(*buffer, (size_t)grown * item_size);
+    if (!p)
+        return 1;
+    *buffer = p;
+    *capacity = grown;
+    return 0;
+}
+
+static int hash_cell(float v, float inv_cell)
+{
+    /* Far-away coordinates share the outermost cells instead of overflowing */
+    float c = floorf(v * inv_cell);
+    return c < -1e9f ? -1000000000 : c > 1e9f ? 1000000000 : (int)c;
+}
+
+static int hash_slot(const ArcadeSpatialHash *hash, int cx, int cy)
+{
+    return (int)(((unsigned)cx * 73856093u) ^ ((unsigned)cy * 19349663u)) & hash->slot_mask;
+}
+
+static int hash_box(const ArcadeAnySprite *sprite, int type, ArcadeHashBox *box)
+{
+    /* Box used for collisions, matching arcade_check_collision and friends */
+    if (type == SPRITE_COLOR && sprite->sprite.active)
+    {
+        const ArcadeSprite *s = &sprite->sprite;
+        *box = (ArcadeHashBox){.x0 = s->x, .y0 = s->y, .x1 = s->x + s->width, .y1 = s->y + s->height};
+    }
+    else if (type == SPRITE_IMAGE && sprite->image_sprite.active)
+    {
+        const ArcadeImageSprite *s = &sprite->image_sprite;
+        *box = (ArcadeHashBox){.x0 = s->x, .y0 = s->y, .x1 = s->x + s->width, .y1 = s->y + s->height};
+    }
+    else if (type == SPRITE_AFFINE)
+    {
+        /* Scaled and rotated sprites collide with the box they are drawn in */
+        ArcadeAffineMap m;
+        if (!affine_map(&sprite->affine_sprite, &m))
+            return 0;
+        *box = (ArcadeHashBox){.x0 = (float)m.bounds.x0, .y0 = (float)m.bounds.y0, .x1 = (float)m.bounds.x1,
+                               .y1 = (float)m.bounds.y1};
+    }
+    else
+    {
+        return 0;
+    }
+    return box->x0 < box->x1 && box->y0 < box->y1;
+}
+
+static long long hash_box_cells(const ArcadeHashBox *box)
+{
+    return (long long)(box->cx1 - box->cx0 + 1) * (box->cy1 - box->cy0 + 1);
+}
+
+static int boxes_overlap(const ArcadeHashBox *a, const ArcadeHashBox *b)
+{
+    return a->x0 < b->x1 && a->x1 > b->x0 && a->y0 < b->y1 && a->y1 > b->y0;
+}
+
+static int push_pair(ArcadeSpatialHash *hash, int a, int b)
+{
+    if (grow_buffer((void **)&hash->pairs, &hash->pair_capacity, hash->pair_count + 1, sizeof(ArcadeCollisionPair)))
+        return 1;
+    hash->pairs[hash->pair_count++] = (ArcadeCollisionPair){a < b ? a : b, a < b ? b : a};
+    return 0;
+}
+
+ArcadeSpatialHash *arcade_create_spatial_hash(float cell_size)
+{
+    ArcadeSpatialHash *hash = calloc(1, sizeof(ArcadeSpatialHash));
+    if (!hash)
+        return NULL;
+    hash->cell_size = cell_size > 0.0f ? cell_size : 0.0f;
+    return hash;
+}
+
+int arcade_spatial_hash_build(ArcadeSpatialHash *hash, const SpriteGroup *group)
+{
+    if (!hash || !group)
+        return 1;
+    int count = group->count;
+    hash->count = 0;
+    hash->large_count = 0;
+    hash->pair_count = 0;
+    hash->result_count = 0;
+    if (grow_buffer((void **)&hash->boxes, &hash->box_capacity, count, sizeof(ArcadeHashBox)) ||
+        grow_buffer((void **)&hash->marks, &hash->mark_capacity, count, sizeof(unsigned)) ||
+        grow_buffer((void **)&hash->large, &hash->large_capacity, count, sizeof(int)))
+    {
+        fprintf(stderr, "Out of memory building spatial hash for %d sprites\n", count);
+        return 1;
+    }
+
+    /* Boxes first; without a fixed cell size, cells are twice the average sprite extent */
+    double extent = 0.0;
+    int colliding = 0;
+    for (int i = 0; i < count; i++)
+    {
+        ArcadeHashBox *box = &hash->boxes[i];
+        if (!hash_box(&group->sprites[i], group->types[i], box))
+        {
+            *box = (ArcadeHashBox){0};
+            continue;
+        }
+        extent += fmax(box->x1 - box->x0, box->y1 - box->y0);
+        colliding++;
+    }
+    float cell = hash->cell_size;
+    if (cell <= 0.0f)
+        cell = colliding ? (float)(2.0 * extent / colliding) : 64.0f;
+    hash->inv_cell = 1.0f / (cell > 1.0f ? cell : 1.0f);
+
+    /* Count the entries each sprite adds; oversized sprites go to the large list */
+    int item_count = 0;
+    for (int i = 0; i < count; i++)
+    {
+        ArcadeHashBox *box = &hash->boxes[i];
+        hash->marks[i] = 0;
+        if (box->x0 >= box->x1)
+            continue;
+        box->cx0 = hash_cell(box->x0, hash->inv_cell);
+        box->cy0 = hash_cell(box->y0, hash->inv_cell);
+        box->cx1 = hash_cell(box->x1, hash->inv_cell);
+        box->cy1 = hash_cell(box->y1, hash->inv_cell);
+        if (hash_box_cells(box) > ARCADE_HASH_MAX_CELLS)
+            hash->large[hash->large_count++] = i;
+        else
+            item_count += (int)hash_box_cells(box);
+    }
+    hash->mark = 0;
+    int slots = 16;
+    while (slots < item_count)
+        slots *= 2;
+    if (grow_buffer((void **)&hash->slot_start, &hash->slot_capacity, slots + 1, sizeof(int)) ||
+        grow_buffer((void **)&hash->items, &hash->item_capacity, item_count, sizeof(ArcadeHashItem)))
+    {
+        fprintf(stderr, "Out of memory building spatial hash for %d sprites\n", count);
+        return 1;
+    }
+    hash->slot_mask = slots - 1;
+
+    /* Counting sort by slot, the same way the tile renderer bins sprites */
+    memset(hash->slot_start, 0, (slots + 1) * sizeof(int));
+    for (int i = 0; i < count; i++)
+    {
+        const ArcadeHashBox *box = &hash->boxes[i];
+        if (box->x0 >= box->x1 || hash_box_cells(box) > ARCADE_HASH_MAX_CELLS)
+            continue;
+        for (int cy = box->cy0; cy <= box->cy1; cy++)
+            for (int cx = box->cx0; cx <= box->cx1; cx++)
+                hash->slot_start[hash_slot(hash, cx, cy) + 1]++;
+    }
+    for (int i = 0; i < slots; i++)
+        hash->slot_start[i + 1] += hash->slot_start[i];
+    for (int i = 0; i < count; i++)
+    {
+        const ArcadeHashBox *box = &hash->boxes[i];
+        if (box->x0 >= box->x1 || hash_box_cells(box) > ARCADE_HASH_MAX_CELLS)
+            continue;
+        for (int cy = box->cy0; cy <= box->cy1; cy++)
+            for (int cx = box->cx0; cx <= box->cx1; cx++)
+                hash->items[hash->slot_start[hash_slot(hash, cx, cy)]++] = (ArcadeHashItem){i, cx, cy};
+    }
+    memmove(hash->slot_start + 1, hash->slot_start, slots * sizeof(int));
+    hash->slot_start[0] = 0;
+    hash->count = count;
+    return 0;
+}
+
+int arcade_spatial_hash_pairs(ArcadeSpatialHash *hash, const ArcadeCollisionPair **pairs)
+{
+    if (!hash)
+        return -1;
+    hash->pair_count = 0;
+    if (pairs)
+        *pairs = NULL;
+    if (hash->count == 0)
+        return 0;
+    for (int slot = 0; slot <= hash->slot_mask; slot++)
+    {
+        int end = hash->slot_start[slot + 1];
+        for (int i = hash->slot_start[slot]; i < end; i++)
+        {
+            const ArcadeHashItem *p = &hash->items[i];
+            const ArcadeHashBox *a = &hash->boxes[p->sprite];
+            for (int j = i + 1; j < end; j++)
+            {
+                const ArcadeHashItem *q = &hash->items[j];
+                const ArcadeHashBox *b = &hash->boxes[q->sprite];
+                if (q->cx != p->cx || q->cy != p->cy || !boxes_overlap(a, b))
+                    continue;
+                /* Both sprites share every cell their overlap touches; report the
+                 * pair only from the cell holding the overlap's top-left corner */
+                if (hash_cell(a->x0 > b->x0 ? a->x0 : b->x0, hash->inv_cell) != p->cx ||
+                    hash_cell(a->y0 > b->y0 ? a->y0 : b->y0, hash->inv_cell) != p->cy)
+                    continue;
+                if (push_pair(hash, p->sprite, q->sprite))
+                    return -1;
+            }
+        }
+    }
+    /* Oversized sprites are not in the cells, so they are tested against everything */
+    for (int l = 0; l < hash->large_count; l++)
+    {
+        int sprite = hash->large[l];
+        for (int i = 0; i < hash->count; i++)
+        {
+            const ArcadeHashBox *other = &hash->boxes[i];
+            if (i == sprite || other->x0 >= other->x1 || !boxes_overlap(&hash->boxes[sprite], other))
+                continue;
+            /* Pairs of two large sprites are reported once, from the lower index */
+            if (hash_box_cells(other) > ARCADE_HASH_MAX_CELLS && i < sprite)
+                continue;
+            if (push_pair(hash, sprite, i))
+                return -1;
+        }
+    }
+    if (pairs)
+        *pairs = hash->pairs;
+    return hash->pair_count;
+}
+
+int arcade_spatial_hash_query(ArcadeSpatialHash *hash, float x, float y, float width, float height, const int **results)
+{
+    if (!hash || width <= 0.0f || height <= 0.0f)
+        return hash ? 0 : -1;
+    ArcadeHashBox area = {.x0 = x, .y0 = y, .x1 = x + width, .y1 = y + height};
+    hash->result_count = 0;
+    if (++hash->mark == 0)
+    {
+        /* Stamp wrapped around: clear the old stamps */
+        memset(hash->marks, 0, hash->count * sizeof(unsigned));
+        hash->mark = 1;
+    }
+    int cx0 = hash_cell(area.x0, hash->inv_cell), cy0 = hash_cell(area.y0, hash->inv_cell);
+    int cx1 = hash_cell(area.x1, hash->inv_cell), cy1 = hash_cell(area.y1, hash->inv_cell);
+    long long cells = (long long)(cx1 - cx0 + 1) * (cy1 - cy0 + 1);
+    if (cells > hash->count)
+    {
+        /* Areas wider than the hash has sprites are cheaper to answer with a plain scan */
+        for (int i = 0; i < hash->count; i++)
+        {
+            const ArcadeHashBox *box = &hash->boxes[i];
+            if (box->x0 < box->x1 && boxes_overlap(box, &area))
+            {
+                if (grow_buffer((void **)&hash->results, &hash->result_capacity, hash->result_count + 1, sizeof(int)))
+                    return -1;
+                hash->results[hash->result_count++] = i;
+            }
+        }
+    }
+    else
+    {
+        for (int cy = cy0; cy <= cy1; cy++)
+            for (int cx = cx0; cx <= cx1; cx++)
+            {
+                int slot = hash_slot(hash, cx, cy);
+                for (int i = hash->slot_start[slot]; i < hash->slot_start[slot + 1]; i++)
+                {
+                    const ArcadeHashItem *item = &hash->items[i];
+                    if (item->cx != cx || item->cy != cy || hash->marks[item->sprite] == hash->mark)
+                        continue;
+                    hash->marks[item->sprite] = hash->mark;
+                    if (!boxes_overlap(&hash->boxes[item->sprite], &area))
+                        continue;
+                    if (grow_buffer((void **)&hash->results, &hash->result_capacity, hash->result_count + 1, sizeof(int)))
+                        return -1;
+                    hash->results[hash->result_count++] = item->sprite;
+                }
+            }
+        for (int l = 0; l < hash->large_count; l++)
+        {
+            if (!boxes_overlap(&hash->boxes[hash->large[l]], &area))
+                continue;
+            if (grow_buffer((void **)&hash->results, &hash->result_capacity, hash->result_count + 1, sizeof(int)))
+                return -1;
+            hash->results[hash->result_count++] = hash->large[l];
+        }
+    }
+    if (results)
+        *results = hash->results;
+    return hash->result_count;
+}
+
+void arcade_free_spatial_hash(ArcadeSpatialHash *hash)
+{
+    if (!hash)
+        return;
+    free(hash->boxes);
+    free(hash->marks);
+    free(hash->slot_start);
+    free(hash->items);
+    free(hash->large);
+    free(hash->pairs);
+    free(hash->results);
+    free(hash);
+}
+
+/* =========================================================================
+ * Batch Collision
+ * Boxes stored as separate x/y/width/height arrays, so one box can be tested
+ * against many with a few vector compares per 4 or 8 boxes.
+ * ========================================================================= */
+
+static int reserve_boxes(ArcadeBoxes *boxes, int capacity)
+{
+    /* One aligned block holding the four arrays; each starts on a cache line */
+    int rounded = (capacity + 15) & ~15;
+    if (rounded <= boxes->capacity && boxes->x)
+        return 0;
+    float *block = alloc_pixels((size_t)rounded * 4 * sizeof(float));
+    if (!block)
+    {
+        fprintf(stderr, "Out of memory allocating %d collision boxes\n", capacity);
+        return 1;
+    }
+    if (boxes->x)
+    {
+        memcpy(block, boxes->x, boxes->count * sizeof(float));
+        memcpy(block + rounded, boxes->y, boxes->count * sizeof(float));
+        memcpy(block + 2 * rounded, boxes->width, boxes->count * sizeof(float));
+        memcpy(block + 3 * rounded, boxes->height, boxes->count * sizeof(float));
+        free_pixels(boxes->x);
+    }
+    boxes->x = block;
+    boxes->y = block + rounded;
+    boxes->width = block + 2 * rounded;
+    boxes->height = block + 3 * rounded;
+    boxes->capacity = rounded;
+    return 0;
+}
+
+int arcade_init_boxes(ArcadeBoxes *boxes, int capacity)
+{
+    if (!boxes)
+        return 1;
+    *boxes = (ArcadeBoxes){0};
+    return reserve_boxes(boxes, capacity > 0 ? capacity : 1);
+}
+
+int arcade_boxes_from_group(ArcadeBoxes *boxes, const SpriteGroup *group)
+{
+    if (!boxes || !group || reserve_boxes(boxes, group->count))
+        return 1;
+    for (int i = 0; i < group->count; i++)
+    {
+        /* Color and image sprites are copied as-is so results match arcade_check_collision;
+         * anything that cannot collide gets a NaN corner, which fails every comparison */
+        const ArcadeAnySprite *sprite = &group->sprites[i];
+        float x = NAN, y = NAN, width = 0.0f, height = 0.0f;
+        ArcadeHashBox box;
+        if (group->types[i] == SPRITE_COLOR && sprite->sprite.active)
+        {
+            x = sprite->sprite.x;
+            y = sprite->sprite.y;
+            width = sprite->sprite.width;
+            height = sprite->sprite.height;
+        }
+        else if (group->types[i] == SPRITE_IMAGE && sprite->image_sprite.active)
+        {
+            x = sprite->image_sprite.x;
+            y = sprite->image_sprite.y;
+            width = sprite->image_sprite.width;
+            height = sprite->image_sprite.height;
+        }
+        else if (group->types[i] == SPRITE_AFFINE && hash_box(sprite, SPRITE_AFFINE, &box))
+        {
+            x = box.x0;
+            y = box.y0;
+            width = box.x1 - box.x0;
+            height = box.y1 - box.y0;
+        }
+        boxes->x[i] = x;
+        boxes->y[i] = y;
+        boxes->width[i] = width;
+        boxes->height[i] = height;
+    }
+    boxes->count = group->count;
+    return 0;
+}
+
+int arcade_collide_boxes(const ArcadeBoxes *boxes, float x, float y, float width, float height, uint32_t *hits)
+{
+    if (!boxes || !hits || boxes->count <= 0)
+        return 0;
+    const float box[4] = {x, y, x + width, y + height};
+    return kernels.overlap_boxes(box, boxes->x, boxes->y, boxes->width, boxes->height, boxes->count, hits);
+}
+
+void arcade_free_boxes(ArcadeBoxes *boxes)
+{
+    if (!boxes)
+        return;
+    free_pixels(boxes->x);
+    *boxes = (ArcadeBoxes){0};
+}
+
+/* =========================================================================
+ * Pixel Collision
+ * Exact overlap tests on the alpha channel. Each image gets a bitmask once
+ * (at load time, or on first use for atlas and pack sprites); two sprites are
+ * compared by ANDing mask words over the rows their rectangles share.
+ * ========================================================================= */
+
+static const ArcadeCollisionMask *sprite_mask(const ArcadeImageSprite *s)
+{
+    /* Cached mask of the sprite's image; NULL for caller-owned pixels or out of memory */
+    ArcadeImageAsset *asset = s->asset;
+    if (!asset)
+        return NULL;
+    ArcadeCollisionMask *mask;
+    mutex_lock(&asset_cache.lock);
+    for (mask = asset->masks; mask; mask = mask->next)
+        if (mask->pixels == s->pixels && mask->width == s->image_width && mask->height == s->image_height)
+            break;
+    mutex_unlock(&asset_cache.lock);
+    if (mask)
+        return mask;
+
+    /* Build without the lock; keep the first copy if another thread raced us */
+    ArcadeCollisionMask *built = build_collision_mask(s->pixels, s->image_width, s->image_height,
+                                                      s->stride ? s->stride : s->image_width);
+    if (!built)
+        return NULL;
+    mutex_lock(&asset_cache.lock);
+    for (mask = asset->masks; mask; mask = mask->next)
+        if (mask->pixels == s->pixels && mask->width == s->image_width && mask->height == s->image_height)
+            break;
+    if (!mask)
+    {
+        built->next = asset->masks;
+        asset->masks = built;
+        asset->bytes += collision_mask_bytes(built);
+        asset_cache.stats.bytes_resident += collision_mask_bytes(built);
+        mask = built;
+        built = NULL;
+    }
+    mutex_unlock(&asset_cache.lock);
+    free(built);
+    return mask;
+}
+
+static uint64_t mask_bits(const uint64_t *row, int offset, int count)
+{
+    /* count (1..64) bits of a mask row starting at bit offset */
+    int w = offset >> 6, shift = offset & 63;
+    uint64_t bits = row[w] >> shift;
+    if (shift + count > 64)
+        bits |= row[w + 1] << (64 - shift);
+    return count < 64 ? bits & ((UINT64_C(1) << count) - 1) : bits;
+}
+
+static uint64_t reverse_bits(uint64_t v)
+{
+    v = ((v >> 1) & UINT64_C(0x5555555555555555)) | ((v & UINT64_C(0x5555555555555555)) << 1);
+    v = ((v >> 2) & UINT64_C(0x3333333333333333)) | ((v & UINT64_C(0x3333333333333333)) << 2);
+    v = ((v >> 4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) | ((v & UINT64_C(0x0F0F0F0F0F0F0F0F)) << 4);
+    return __builtin_bswap64(v);
+}
+
+typedef struct
+{
+    const ArcadeImageSprite *sprite;
+    const ArcadeCollisionMask *mask; /* NULL: test alpha through the orientation mapping */
+    int x0, y0;                      /* Screen position of the drawn rectangle */
+    int flip_h, flip_v;              /* Mirroring when the mask is used */
+    int ox, oy, ux, uy, vx, vy;      /* Orientation mapping when it is not */
+} ArcadeMaskView;
+
+static void mask_view(ArcadeMaskView *view, const ArcadeImageSprite *s, const ArcadeRegion *r)
+{
+    int turn = (s->orientation >> 2) & 3;
+    view->sprite = s;
+    view->x0 = r->x0;
+    view->y0 = r->y0;
+    /* A half turn is both flips; quarter turns fall back to the pixels */
+    view->mask = turn & 1 ? NULL : sprite_mask(s);
+    view->flip_h = !!(s->orientation & ARCADE_ORIENT_FLIP_H) ^ (turn == 2);
+    view->flip_v = !!(s->orientation & ARCADE_ORIENT_FLIP_V) ^ (turn == 2);
+    orientation_map(s, &view->ox, &view->oy, &view->ux, &view->uy, &view->vx, &view->vy);
+}
+
+static uint64_t mask_view_bits(const ArcadeMaskView *view, int x, int y, int count)
+{
+    /* Solid pixels among count screen pixels from (x, y), bit i for x + i */
+    const ArcadeImageSprite *s = view->sprite;
+    int u = x - view->x0, v = y - view->y0;
+    if (view->mask)
+    {
+        const ArcadeCollisionMask *mask = view->mask;
+        const uint64_t *row = mask->bits + (size_t)(view->flip_v ? mask->height - 1 - v : v) * mask->words;
+        if (!view->flip_h)
+            return mask_bits(row, u, count);
+        return reverse_bits(mask_bits(row, mask->width - u - count, count)) >> (64 - count);
+    }
+    int stride = s->stride ? s->stride : s->image_width;
+    int sx = view->ox + u * view->ux + v * view->vx, sy = view->oy + u * view->uy + v * view->vy;
+    const uint32_t *src = s->pixels + (ptrdiff_t)sy * stride + sx;
+    ptrdiff_t step = view->ux + (ptrdiff_t)view->uy * stride;
+    uint64_t bits = 0;
+    for (int i = 0; i < count; i++)
+        bits |= (uint64_t)((src[i * step] >> 24) >= ARCADE_MASK_ALPHA) << i;
+    return bits;
+}
+
+int arcade_check_pixel_collision(const ArcadeImageSprite *a, const ArcadeImageSprite *b)
+{
+    if (!a || !b || !a->active || !b->active)
+        return 0;
+    if (!(a->x < b->x + b->width && a->x + a->width > b->x && a->y < b->y + b->height && a->y + a->height > b->y))
+        return 0;
+    /* Compare the pixels as drawn: same rectangles as the renderer */
+    ArcadeAnySprite any_a = {.image_sprite = *a}, any_b = {.image_sprite = *b};
+    ArcadeRegion ra, rb;
+    if (!sprite_bounds(&any_a, SPRITE_IMAGE, &ra) || !sprite_bounds(&any_b, SPRITE_IMAGE, &rb))
+        return 0;
+    int x0 = ra.x0 > rb.x0 ? ra.x0 : rb.x0, x1 = ra.x1 < rb.x1 ? ra.x1 : rb.x1;
+    int y0 = ra.y0 > rb.y0 ? ra.y0 : rb.y0, y1 = ra.y1 < rb.y1 ? ra.y1 : rb.y1;
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+    ArcadeMaskView va, vb;
+    mask_view(&va, a, &ra);
+    mask_view(&vb, b, &rb);
+    for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x += 64)
+        {
+            int count = x1 - x < 64 ? x1 - x : 64;
+            if (mask_view_bits(&va, x, y, count) & mask_view_bits(&vb, x, y, count))
+                return 1;
+        }
+    return 0;
+}
+
+/* =========================================================================
+ * Swept Collision
+ * Time of impact of a box moving in a straight line, so fast sprites can be
+ * stopped at the first thing they would pass through within one frame step.
+ * ========================================================================= */
+
+static int sweep_box(const ArcadeHashBox *mover, float dx, float dy, const ArcadeHashBox *box, ArcadeSweepHit *hit)
+{
+    /* Slab test: the interval of the move during which each axis overlaps, intersected.
+     * A still axis must already overlap; touching edges never count, like boxes_overlap */
+    float enter_x = -INFINITY, leave_x = INFINITY, enter_y = -INFINITY, leave_y = INFINITY;
+    if (dx > 0.0f)
+    {
+        enter_x = (box->x0 - mover->x1) / dx;
+        leave_x = (box->x1 - mover->x0) / dx;
+    }
+    else if (dx < 0.0f)
+    {
+        enter_x = (box->x1 - mover->x0) / dx;
+        leave_x = (box->x0 - mover->x1) / dx;
+    }
+    else if (!(mover->x0 < box->x1 && mover->x1 > box->x0))
+    {
+        return 0;
+    }
+    if (dy > 0.0f)
+    {
+        enter_y = (box->y0 - mover->y1) / dy;
+        leave_y = (box->y1 - mover->y0) / dy;
+    }
+    else if (dy < 0.0f)
+    {
+        enter_y = (box->y1 - mover->y0) / dy;
+        leave_y = (box->y0 - mover->y1) / dy;
+    }
+    else if (!(mover->y0 < box->y1 && mover->y1 > box->y0))
+    {
+        return 0;
+    }
+    float enter = enter_x > enter_y ? enter_x : enter_y;
+    float leave = leave_x < leave_y ? leave_x : leave_y;
+    if (!(enter < leave) || leave <= 0.0f || enter >= 1.0f)
+        return 0;
+    *hit = (ArcadeSweepHit){.time = 0.0f, .normal_x = 0.0f, .normal_y = 0.0f, .index = -1};
+    if (enter < 0.0f)
+        return 1; /* Already overlapping: no face was crossed */
+    hit->time = enter;
+    if (enter_x >= enter_y)
+        hit->normal_x = dx > 0.0f ? -1.0f : 1.0f;
+    else
+        hit->normal_y = dy > 0.0f ? -1.0f : 1.0f;
+    return 1;
+}
+
+int arcade_sweep_box(float x, float y, float width, float height, float dx, float dy, float box_x, float box_y,
+                     float box_width, float box_height, ArcadeSweepHit *hit)
+{
+    if (!hit || width <= 0.0f || height <= 0.0f || box_width <= 0.0f || box_height <= 0.0f)
+        return 0;
+    ArcadeHashBox mover = {.x0 = x, .y0 = y, .x1 = x + width, .y1 = y + height};
+    ArcadeHashBox box = {.x0 = box_x, .y0 = box_y, .x1 = box_x + box_width, .y1 = box_y + box_height};
+    return sweep_box(&mover, dx, dy, &box, hit);
+}
+
+int arcade_sweep_group(float x, float y, float width, float height, float dx, float dy, const SpriteGroup *group,
+                       const int *indices, int count, ArcadeSweepHit *hit)
+{
+    if (!hit || !group || width <= 0.0f || height <= 0.0f)
+        return 0;
+    if (!indices)
+        count = group->count;
+    ArcadeHashBox mover = {.x0 = x, .y0 = y, .x1 = x + width, .y1 = y + height};
+    int found = 0;
+    for (int k = 0; k < count; k++)
+    {
+        int i = indices ? indices[k] : k;
+        ArcadeHashBox box;
+        ArcadeSweepHit candidate;
+        if (i < 0 || i >= group->count || !hash_box(&group->sprites[i], group->types[i], &box) ||
+            !sweep_box(&mover, dx, dy, &box, &candidate))
+            continue;
+        /* Earliest contact wins; ties keep the first sprite listed */
+        if (!found || candidate.time < hit->time)
+        {
+            *hit = candidate;
+            hit->index = i;
+            found = 1;
+        }
+    }
+    return found;
+}
+
+/* =========================================================================
+ * Audio
+ * A mixer thread sums up to ARCADE_MAX_VOICES voices of pre-decoded sounds
+ * (44.1 kHz stereo 16-bit) and hands fixed periods to a sink. Game threads
+ * talk to it only through a single-producer ring of commands, so the mixer
+ * never waits on a lock held by the game.
+ * ========================================================================= */
+#define ARCADE_AUDIO_RATE 44100      /* Mixer sample rate (frames per second) */
+#define ARCADE_AUDIO_PERIOD 512      /* Frames mixed per sink write (~11.6 ms) */
+#define ARCADE_MAX_VOICES 32         /* Sounds that can play at the same time */
+#define ARCADE_AUDIO_QUEUE_SIZE 256  /* Pending commands (power of two) */
+
+struct ArcadeSound
+{
+    volatile long refs; /* Owners: the loader's handle, each playing voice and the path cache */
+    int frame_count;    /* Stereo frames in samples */
+    int16_t samples[];  /* Interleaved left/right PCM at ARCADE_AUDIO_RATE */
+};
+
+enum
+{
+    AUDIO_CMD_PLAY,
+    AUDIO_CMD_STOP_ALL,
+    AUDIO_CMD_VOLUME
+};
+
+typedef struct
+{
+    int type;           /* AUDIO_CMD_* */
+    ArcadeSound *sound; /* Sound to play (reference owned by the command) */
+    int volume;         /* Voice or master volume (8.8 fixed point) */
+    int loop;           /* 1 = restart the sound when it ends */
+} ArcadeAudioCommand;
+
+typedef struct
+{
+    ArcadeSound *sound; /* Playing sound, or NULL for a free voice */
+    int position;       /* Next frame to mix */
+    int volume;         /* 8.8 fixed point */
+    int loop;           /* 1 = restart the sound when it ends */
+} ArcadeVoice;
+
+typedef struct ArcadeAudioSink
+{
+    /* Consumes one period; blocks at playback speed, which paces the mixer. Returns 0 or 1 on failure. */
+    int (*write)(struct ArcadeAudioSink *sink, const int16_t *frames, int frame_count);
+    void (*close)(struct ArcadeAudioSink *sink);
+    FILE *file;         /* WAV sink output */
+    long data_bytes;    /* PCM bytes written to file */
+#ifdef _WIN32
+    HWAVEOUT waveout;   /* waveOut device */
+    HANDLE done_event;  /* Signalled when the device finishes a buffer */
+    WAVEHDR headers[4]; /* Buffers rotating through the device */
+    int16_t buffers[4][ARCADE_AUDIO_PERIOD * 2];
+    int next_buffer;    /* Next header to fill */
+#else
+    void *alsa_lib;     /* dlopen handle of libasound.so.2 */
+    void *pcm;          /* snd_pcm_t * */
+    long (*pcm_writei)(void *pcm, const void *buffer, unsigned long frames);
+    int (*pcm_recover)(void *pcm, int err, int silent);
+    int (*pcm_drain)(void *pcm);
+    int (*pcm_close)(void *pcm);
+#endif
+} ArcadeAudioSink;
+
+typedef struct ArcadeNamedSound
+{
+    char *path;                    /* File passed to arcade_play_sound */
+    ArcadeSound *sound;            /* Decoded once, reused for every play */
+    struct ArcadeNamedSound *next; /* Next cached file */
+} ArcadeNamedSound;
+
+typedef struct
+{
+    ArcadeMutex lock;                                  /* Serializes API callers; never taken by the mixer */
+    int open;                                          /* 1 while the mixer thread runs */
+    ArcadeThread thread;                               /* Mixer thread */
+    volatile long shutdown;                            /* 1 = mixer thread exits */
+    ArcadeAudioSink sink;                              /* Output; replaced by the null sink if it fails */
+    ArcadeAudioCommand queue[ARCADE_AUDIO_QUEUE_SIZE]; /* Commands from the game */
+    volatile long queue_head;                          /* Next slot written by the game */
+    volatile long queue_tail;                          /* Next slot read by the mixer */
+    ArcadeVoice voices[ARCADE_MAX_VOICES];             /* Mixer-thread only */
+    int master_volume;                                 /* 8.8 fixed point; owned by the mixer while open */
+    ArcadeNamedSound *named;                           /* Cache for arcade_play_sound */
+} ArcadeMixer;
+
+static ArcadeMixer mixer = {.lock = ARCADE_MUTEX_INITIALIZER, .master_volume = 256};
+
+static void release_sound(ArcadeSound *sound)
+{
+    if (sound && atomic_fetch_add_int(&sound->refs, -1) == 1)
+        free(sound);
+}
+
+static int read_le16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static long read_le32(const unsigned char *p)
+{
+    return (long)((unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24));
+}
+
+static int wav_sample(const unsigned char *frame, int channel, int bits)
+{
+    if (bits == 8)
+        return (frame[channel] - 128) * 256;
+    return (int16_t)read_le16(frame + channel * 2);
+}
+
+static ArcadeSound *decode_wav(const unsigned char *data, long size, const char *name)
+{
+    /* PCM WAV (8/16-bit, any channel count and rate) -> stereo 16-bit at the mixer rate */
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        fprintf(stderr, "%s is not a WAV file\n", name);
+        return NULL;
+    }
+    int format = 0, channels = 0, bits = 0, block_align = 0;
+    long rate = 0, pcm_size = 0;
+    const unsigned char *pcm = NULL;
+    for (long offset = 12; offset + 8 <= size;)
+    {
+        const unsigned char *chunk = data + offset;
+        long chunk_size = read_le32(chunk + 4);
+        long available = size - offset - 8;
+        if (chunk_size < 0 || chunk_size > available)
+            chunk_size = available;
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            format = read_le16(chunk + 8);
+            channels = read_le16(chunk + 10);
+            rate = read_le32(chunk + 12);
+            block_align = read_le16(chunk + 20);
+            bits = read_le16(chunk + 22);
+            if (format == 0xFFFE && chunk_size >= 40)
+                format = read_le16(chunk + 32); /* WAVE_FORMAT_EXTENSIBLE: sub-format GUID starts with the tag */
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            pcm = chunk + 8;
+            pcm_size = chunk_size;
+        }
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+    if (format != 1 || (bits != 8 && bits != 16) || channels < 1 || rate <= 0 || !pcm ||
+        block_align < channels * bits / 8)
+    {
+        fprintf(stderr, "Unsupported WAV format in %s (need 8- or 16-bit PCM)\n", name);
+        return NULL;
+    }
+
+    long in_frames = pcm_size / block_align;
+    long out_frames = (long)(((long long)in_frames * ARCADE_AUDIO_RATE + rate - 1) / rate);
+    ArcadeSound *sound = malloc(sizeof(ArcadeSound) + (size_t)out_frames * 2 * sizeof(int16_t));
+    if (!sound)
+        return NULL;
+    sound->refs = 1;
+    sound->frame_count = (int)out_frames;
+    int right = channels > 1 ? 1 : 0;
+    for (long i = 0; i < out_frames; i++)
+    {
+        /* Linear interpolation between the two nearest source frames */
+        double src = (double)i * rate / ARCADE_AUDIO_RATE;
+        long i0 = (long)src;
+        long i1 = i0 + 1 < in_frames ? i0 + 1 : i0;
+        double t = src - i0;
+        const unsigned char *f0 = pcm + i0 * block_align, *f1 = pcm + i1 * block_align;
+        sound->samples[i * 2] = (int16_t)(wav_sample(f0, 0, bits) * (1.0 - t) + wav_sample(f1, 0, bits) * t);
+        sound->samples[i * 2 + 1] = (int16_t)(wav_sample(f0, right, bits) * (1.0 - t) + wav_sample(f1, right, bits) * t);
+    }
+    return sound;
+}
+
+ArcadeSound *arcade_load_sound(const char *audio_file_path)
+{
+    if (!audio_file_path)
+        return NULL;
+    FILE *file = fopen(audio_file_path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot open %s\n", audio_file_path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = size > 0 ? malloc(size) : NULL;
+    if (!data || fread(data, 1, size, file) != (size_t)size)
+    {
+        fprintf(stderr, "Cannot read %s\n", audio_file_path);
+        free(data);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    ArcadeSound *sound = decode_wav(data, size, audio_file_path);
+    free(data);
+    return sound;
+}
+
+void arcade_free_sound(ArcadeSound *sound)
+{
+    /* Voices still playing the sound keep it alive until they finish */
+    release_sound(sound);
+}
+
+/* ---- Sinks ---- */
+
+static int null_sink_write(ArcadeAudioSink *sink, const int16_t *frames, int frame_count)
+{
+    (void)sink;
+    (void)frames;
+    arcade_sleep(frame_count * 1000 / ARCADE_AUDIO_RATE); /* Consume audio at roughly real time */
+    return 0;
+}
+
+static void null_sink_close(ArcadeAudioSink *sink)
+{
+    (void)sink;
+}
+
+static void put_le(unsigned char *p, unsigned long value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        p[i] = (unsigned char)(value >> (8 * i));
+}
+
+static void write_wav_header(FILE *file, long data_bytes)
+{
+    /* Canonical 44-byte header for 16-bit stereo PCM at the mixer rate */
+    unsigned char header[44];
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, 36 + data_bytes, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);                    /* fmt chunk size */
+    put_le(header + 20, 1, 2);                     /* PCM */
+    put_le(header + 22, 2, 2);                     /* Channels */
+    put_le(header + 24, ARCADE_AUDIO_RATE, 4);     /* Frames per second */
+    put_le(header + 28, ARCADE_AUDIO_RATE * 4, 4); /* Bytes per second */
+    put_le(header + 32, 4, 2);                     /* Bytes per frame */
+    put_le(header + 34, 16, 2);                    /* Bits per sample */
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data_bytes, 4);
+    fseek(file, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), file);
+}
+
+static int wav_sink_write(ArcadeAudioSink *sink, const int16_t *frames, int frame_count)
+{
+    /* Samples are written little-endian regardless of the host */
+    unsigned char bytes[ARCADE_AUDIO_PERIOD * 4];
+    for (int i = 0; i < frame_count * 2; i++)
+    {
+        bytes[i * 2] = (unsigned char)(frames[i] & 0xFF);
+        bytes[i * 2 + 1] = (unsigned char)((frames[i] >> 8) & 0xFF);
+    }
+    if (fwrite(bytes, 4, frame_count, sink->file) != (size_t)frame_count)
+        return 1;
+    sink->data_bytes += frame_count * 4;
+    return null_sink_write(sink, frames, frame_count);
+}
+
+static void wav_sink_close(ArcadeAudioSink *sink)
+{
+    write_wav_header(sink->file, sink->data_bytes); /* Patch the sizes now that they are known */
+    fclose(sink->file);
+    sink->file = NULL;
+}
+
+static int open_wav_sink(ArcadeAudioSink *sink, const char *path)
+{
+    sink->file = path ? fopen(path, "wb") : NULL;
+    if (!sink->file)
+    {
+        fprintf(stderr, "Cannot create %s\n", path ? path : "(null)");
+        return 1;
+    }
+    sink->data_bytes = 0;
+    write_wav_header(sink->file, 0);
+    sink->write = wav_sink_write;
+    sink->close = wav_sink_close;
+    return 0;
+}
+
+#ifdef _WIN32
+static int device_sink_write(ArcadeAudioSink *sink, const int16_t *frames, int frame_count)
+{
+    /* Four buffers rotate through the device; wait for the oldest to come back */
+    WAVEHDR *header = &sink->headers[sink->next_buffer];
+    while (header->dwFlags & WHDR_INQUEUE)
+        WaitForSingleObject(sink->done_event, INFINITE);
+    if (header->dwFlags & WHDR_PREPARED)
+        waveOutUnprepareHeader(sink->waveout, header, sizeof(WAVEHDR));
+    memcpy(sink->buffers[sink->next_buffer], frames, frame_count * 4);
+    header->lpData = (LPSTR)sink->buffers[sink->next_buffer];
+    header->dwBufferLength = frame_count * 4;
+    header->dwFlags = 0;
+    if (waveOutPrepareHeader(sink->waveout, header, sizeof(WAVEHDR)) != MMSYSERR_NOERROR ||
+        waveOutWrite(sink->waveout, header, sizeof(WAVEHDR)) != MMSYSERR_NOERROR)
+        return 1;
+    sink->next_buffer = (sink->next_buffer + 1) % 4;
+    return 0;
+}
+
+static void device_sink_close(ArcadeAudioSink *sink)
+{
+    waveOutReset(sink->waveout);
+    for (int i = 0; i < 4; i++)
+        if (sink->headers[i].dwFlags & WHDR_PREPARED)
+            waveOutUnprepareHeader(sink->waveout, &sink->headers[i], sizeof(WAVEHDR));
+    waveOutClose(sink->waveout);
+    CloseHandle(sink->done_event);
+}
+
+static int open_device_sink(ArcadeAudioSink *sink)
+{
+    WAVEFORMATEX format = {0};
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 2;
+    format.nSamplesPerSec = ARCADE_AUDIO_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = 4;
+    format.nAvgBytesPerSec = ARCADE_AUDIO_RATE * 4;
+    sink->done_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!sink->done_event)
+        return 1;
+    if (waveOutOpen(&sink->waveout, WAVE_MAPPER, &format, (DWORD_PTR)sink->done_event, 0, CALLBACK_EVENT) !=
+        MMSYSERR_NOERROR)
+    {
+        CloseHandle(sink->done_event);
+        fprintf(stderr, "Cannot open audio device\n");
+        return 1;
+    }
+    memset(sink->headers, 0, sizeof(sink->headers));
+    sink->next_buffer = 0;
+    sink->write = device_sink_write;
+    sink->close = device_sink_close;
+    return 0;
 }
-
-ArcadeAnimatedSprite arcade_create_animated_sprite(float x, float y, float w, float h, const char **filenames, int frame_count, int frame_interval)
+#else
+static int device_sink_write(ArcadeAudioSink *sink, const int16_t *frames, int frame_count)
 {
-    ArcadeAnimatedSprite anim = {0};
-    anim.frames = malloc(frame_count * sizeof(ArcadeImageSprite));
-    anim.frame_count = frame_count;
-    anim.frame_interval = frame_interval;
-    for (int i = 0; i < frame_count; i++)
+    while (frame_count > 0)
     {
-        anim.frames[i] = arcade_create_image_sprite(x, y, w, h, filenames[i]);
-        if (!anim.frames[i].pixels)
+        long written = sink->pcm_writei(sink->pcm, frames, (unsigned long)frame_count);
+        if (written < 0)
         {
-            for (int j = 0; j < i; j++)
-                arcade_free_image_sprite(&anim.frames[j]);
-            free(anim.frames);
-            return (ArcadeAnimatedSprite){0};
+            /* Underrun or suspend: let ALSA recover, then retry */
+            if (sink->pcm_recover(sink->pcm, (int)written, 1) < 0)
+                return 1;
+            continue;
         }
+        frames += written * 2;
+        frame_count -= (int)written;
     }
-    anim.frames[0].active = 1;
-    return anim;
+    return 0;
 }
 
-void arcade_free_animated_sprite(ArcadeAnimatedSprite *anim)
+static void device_sink_close(ArcadeAudioSink *sink)
 {
-    if (!anim || !anim->frames)
-        return;
-    for (int i = 0; i < anim->frame_count; i++)
-        arcade_free_image_sprite(&anim->frames[i]);
-    free(anim->frames);
-    anim->frames = NULL;
-    anim->frame_count = 0;
+    sink->pcm_drain(sink->pcm);
+    sink->pcm_close(sink->pcm);
+    dlclose(sink->alsa_lib);
+    sink->pcm = NULL;
+    sink->alsa_lib = NULL;
 }
 
-void arcade_move_animated_sprite(ArcadeAnimatedSprite *anim, float gravity, int window_height)
+static int open_device_sink(ArcadeAudioSink *sink)
 {
-    if (!anim || !anim->frames[0].active)
-        return;
-    ArcadeImageSprite *current = &anim->frames[anim->current_frame];
-    arcade_move_image_sprite(current, gravity, window_height);
-    for (int i = 0; i < anim->frame_count; i++)
+    /* ALSA is loaded at run time so building and running without it still works */
+    int (*pcm_open)(void **pcm, const char *name, int stream, int mode);
+    int (*pcm_set_params)(void *pcm, int format, int access, unsigned int channels, unsigned int rate,
+                          int soft_resample, unsigned int latency_us);
+    sink->alsa_lib = dlopen("libasound.so.2", RTLD_NOW);
+    if (!sink->alsa_lib)
     {
-        anim->frames[i].x = current->x;
-        anim->frames[i].y = current->y;
-        anim->frames[i].vx = current->vx;
-        anim->frames[i].vy = current->vy;
+        fprintf(stderr, "Cannot load libasound.so.2\n");
+        return 1;
     }
-    if (++anim->frame_counter >= anim->frame_interval)
+    *(void **)&pcm_open = dlsym(sink->alsa_lib, "snd_pcm_open");
+    *(void **)&pcm_set_params = dlsym(sink->alsa_lib, "snd_pcm_set_params");
+    *(void **)&sink->pcm_writei = dlsym(sink->alsa_lib, "snd_pcm_writei");
+    *(void **)&sink->pcm_recover = dlsym(sink->alsa_lib, "snd_pcm_recover");
+    *(void **)&sink->pcm_drain = dlsym(sink->alsa_lib, "snd_pcm_drain");
+    *(void **)&sink->pcm_close = dlsym(sink->alsa_lib, "snd_pcm_close");
+    /* SND_PCM_STREAM_PLAYBACK = 0, SND_PCM_FORMAT_S16_LE = 2, SND_PCM_ACCESS_RW_INTERLEAVED = 3 */
+    if (!pcm_open || !pcm_set_params || !sink->pcm_writei || !sink->pcm_recover || !sink->pcm_drain ||
+        !sink->pcm_close || pcm_open(&sink->pcm, "default", 0, 0) < 0)
     {
-        anim->current_frame = (anim->current_frame + 1) % anim->frame_count;
-        anim->frame_counter = 0;
+        fprintf(stderr, "Cannot open audio device\n");
+        dlclose(sink->alsa_lib);
+        sink->alsa_lib = NULL;
+        return 1;
     }
+    if (pcm_set_params(sink->pcm, 2, 3, 2, ARCADE_AUDIO_RATE, 1, 50000) < 0)
+    {
+        fprintf(stderr, "Cannot configure audio device\n");
+        sink->pcm_close(sink->pcm);
+        dlclose(sink->alsa_lib);
+        sink->alsa_lib = NULL;
+        return 1;
+    }
+    sink->write = device_sink_write;
+    sink->close = device_sink_close;
+    return 0;
 }
+#endif
 
-int arcade_check_animated_collision(ArcadeAnimatedSprite *anim, ArcadeImageSprite *other)
-{
-    if (!anim || !other || !anim->frames[0].active || !other->active)
-        return 0;
-    return arcade_check_image_collision(&anim->frames[anim->current_frame], other);
-}
-
-/* =========================================================================
- * Rendering
- * ========================================================================= */
+/* ---- Mixer thread ---- */
 
-static void draw_sprite(ArcadeAnySprite *sprite, int type)
+static void apply_audio_commands(void)
 {
-    if (!sprite)
-        return;
-    if (type == SPRITE_COLOR && sprite->sprite.active)
+    long tail = mixer.queue_tail;
+    long head = atomic_load_int(&mixer.queue_head);
+    for (; tail != head; tail++)
     {
-        ArcadeSprite *s = &sprite->sprite;
-        int x_start = (int)s->x;
-        int y_start = (int)s->y;
-        int x_end = x_start + (int)s->width;
-        int y_end = y_start + (int)s->height;
-        unsigned int color = s->color;
-        /* Draw a solid rectangle for color-based sprites */
-        for (int y = y_start; y < y_end && y < state.height; y++)
+        ArcadeAudioCommand *cmd = &mixer.queue[tail & (ARCADE_AUDIO_QUEUE_SIZE - 1)];
+        if (cmd->type == AUDIO_CMD_PLAY)
+        {
+            /* Use a free voice, or steal the one that has played longest */
+            ArcadeVoice *voice = &mixer.voices[0];
+            for (int i = 0; i < ARCADE_MAX_VOICES; i++)
+            {
+                if (!mixer.voices[i].sound)
+                {
+                    voice = &mixer.voices[i];
+                    break;
+                }
+                if (mixer.voices[i].position > voice->position)
+                    voice = &mixer.voices[i];
+            }
+            release_sound(voice->sound);
+            voice->sound = cmd->sound;
+            voice->position = 0;
+            voice->volume = cmd->volume;
+            voice->loop = cmd->loop;
+        }
+        else if (cmd->type == AUDIO_CMD_STOP_ALL)
         {
-            if (y < 0)
-                continue; /* Skip pixels outside the top of the window */
-            for (int x = x_start; x < x_end && x < state.width; x++)
+            for (int i = 0; i < ARCADE_MAX_VOICES; i++)
             {
-                if (x < 0)
-                    continue;                              /* Skip pixels outside the left of the window */
-                state.pixels[y * state.width + x] = color; /* Set pixel to sprite color */
+                release_sound(mixer.voices[i].sound);
+                mixer.voices[i].sound = NULL;
             }
         }
+        else if (cmd->type == AUDIO_CMD_VOLUME)
+        {
+            mixer.master_volume = cmd->volume;
+        }
     }
-    else if (type == SPRITE_IMAGE && sprite->image_sprite.active && sprite->image_sprite.pixels)
+    atomic_store_int(&mixer.queue_tail, tail);
+}
+
+static void mix_period(int16_t *out)
+{
+    int32_t mix[ARCADE_AUDIO_PERIOD * 2] = {0};
+    for (int v = 0; v < ARCADE_MAX_VOICES; v++)
     {
-        ArcadeImageSprite *s = &sprite->image_sprite;
-        int x_start = (int)s->x;
-        int y_start = (int)s->y;
-        int x_end = x_start + (int)s->width;
-        int y_end = y_start + (int)s->height;
-        int iw = s->image_width;
-        int ih = s->image_height;
-        /* Draw image-based sprite with alpha blending */
-        for (int y = y_start, sy = 0; y < y_end && y < state.height && sy < ih; y++, sy++)
-        {
-            if (y < 0)
-                continue; /* Skip pixels outside the top of the window */
-            for (int x = x_start, sx = 0; x < x_end && x < state.width && sx < iw; x++, sx++)
+        ArcadeVoice *voice = &mixer.voices[v];
+        int frame = 0;
+        while (voice->sound && frame < ARCADE_AUDIO_PERIOD)
+        {
+            int count = voice->sound->frame_count - voice->position;
+            if (count > ARCADE_AUDIO_PERIOD - frame)
+                count = ARCADE_AUDIO_PERIOD - frame;
+            const int16_t *src = voice->sound->samples + voice->position * 2;
+            for (int i = 0; i < count * 2; i++)
+                mix[frame * 2 + i] += (src[i] * voice->volume) >> 8;
+            frame += count;
+            voice->position += count;
+            if (voice->position >= voice->sound->frame_count)
             {
-                if (x < 0)
-                    continue; /* Skip pixels outside the left of the window */
-                uint32_t pixel = s->pixels[sy * iw + sx];
-                if ((pixel >> 24) > 0) /* Only draw if pixel is not fully transparent */
+                if (voice->loop && voice->sound->frame_count > 0)
+                    voice->position = 0;
+                else
                 {
-                    state.pixels[y * state.width + x] = pixel; /* Copy pixel to buffer */
+                    release_sound(voice->sound);
+                    voice->sound = NULL;
                 }
             }
         }
     }
+    for (int i = 0; i < ARCADE_AUDIO_PERIOD * 2; i++)
+    {
+        /* 32 voices at 4x can sum to ~4.2M; times a 4x master that no longer fits 32 bits */
+        int64_t sample = ((int64_t)mix[i] * mixer.master_volume) >> 8;
+        out[i] = (int16_t)(sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample);
+    }
 }
 
-void arcade_render_scene(ArcadeAnySprite *sprites, int count, int *types)
+ARCADE_THREAD_FUNC(mixer_thread)
 {
-    for (int i = 0; i < state.width * state.height; i++)
+    (void)arg;
+    int16_t out[ARCADE_AUDIO_PERIOD * 2];
+    while (!atomic_load_int(&mixer.shutdown))
     {
-        state.pixels[i] = state.bg_color;
+        apply_audio_commands();
+        mix_period(out);
+        if (mixer.sink.write(&mixer.sink, out, ARCADE_AUDIO_PERIOD) != 0)
+        {
+            /* Keep voices advancing so play/stop still behave, just silently */
+            fprintf(stderr, "Audio output failed; continuing without sound\n");
+            mixer.sink.close(&mixer.sink);
+            mixer.sink.write = null_sink_write;
+            mixer.sink.close = null_sink_close;
+        }
     }
-    for (int i = 0; i < count; i++)
+    ARCADE_THREAD_RETURN;
+}
+
+/* ---- Public API ---- */
+
+static void stop_mixer_locked(void)
+{
+    if (!mixer.open)
+        return;
+    atomic_store_int(&mixer.shutdown, 1);
+    thread_join(mixer.thread);
+    mixer.open = 0;
+    /* Drop whatever the mixer did not get to, then the voices */
+    long head = mixer.queue_head;
+    for (long tail = mixer.queue_tail; tail != head; tail++)
+        release_sound(mixer.queue[tail & (ARCADE_AUDIO_QUEUE_SIZE - 1)].sound);
+    mixer.queue_head = mixer.queue_tail = 0;
+    for (int i = 0; i < ARCADE_MAX_VOICES; i++)
     {
-        draw_sprite(&sprites[i], types[i]);
+        release_sound(mixer.voices[i].sound);
+        mixer.voices[i].sound = NULL;
     }
-#ifdef _WIN32
-    HDC memDC = CreateCompatibleDC(state.hdc);
-    SelectObject(memDC, state.hbitmap);
-    BitBlt(state.hdc, 0, 0, state.width, state.height, memDC, 0, 0, SRCCOPY);
-    DeleteDC(memDC);
-#else
-    XPutImage(state.display, state.window, state.gc, state.image, 0, 0, 0, 0, state.width, state.height);
-#endif
+    mixer.sink.close(&mixer.sink);
 }
 
-void arcade_render_text(const char *text, float x, float y, unsigned int color)
+static void close_audio_locked(void)
 {
-    if (!text)
-        return;
-#ifdef _WIN32
-    if (!state.hfont)
+    stop_mixer_locked();
+    while (mixer.named)
     {
-        fprintf(stderr, "arcade_render_text: Skipping (font=%p)\n", state.hfont);
-        return;
+        ArcadeNamedSound *entry = mixer.named;
+        mixer.named = entry->next;
+        release_sound(entry->sound);
+        free(entry->path);
+        free(entry);
     }
-    HDC memDC = CreateCompatibleDC(state.hdc);
-    SelectObject(memDC, state.hbitmap);
-    SelectObject(memDC, state.hfont);
-    SetTextColor(memDC, color);
-    SetBkMode(memDC, TRANSPARENT);
-    TextOut(memDC, (int)x, (int)y, text, strlen(text));
-    BitBlt(state.hdc, 0, 0, state.width, state.height, memDC, 0, 0, SRCCOPY);
-    DeleteDC(memDC);
-#else
-    if (!state.font)
+}
+
+static int open_audio_locked(int sink, const char *wav_path)
+{
+    stop_mixer_locked();
+    memset(&mixer.sink, 0, sizeof(mixer.sink));
+    if (sink == ARCADE_AUDIO_AUTO)
     {
-        fprintf(stderr, "arcade_render_text: Skipping (font=%p)\n", state.font);
-        return;
+        /* Headless runs (CI, servers) get silent output instead of a device */
+        const char *headless = getenv("ARCADE_HEADLESS");
+        if (headless && headless[0] && strcmp(headless, "0") != 0)
+            sink = ARCADE_AUDIO_NULL;
+        else if (open_device_sink(&mixer.sink) != 0)
+        {
+            fprintf(stderr, "No audio device; sound is muted\n");
+            sink = ARCADE_AUDIO_NULL;
+        }
     }
-    XSetForeground(state.display, state.gc, color);
-    XSetFont(state.display, state.gc, state.font->fid);
-    XDrawString(state.display, state.window, state.gc, (int)x, (int)y, text, strlen(text));
-    XFlush(state.display);
-#endif
+    else if (sink == ARCADE_AUDIO_DEVICE && open_device_sink(&mixer.sink) != 0)
+        return 1;
+    else if (sink == ARCADE_AUDIO_WAV && open_wav_sink(&mixer.sink, wav_path) != 0)
+        return 1;
+    if (sink == ARCADE_AUDIO_NULL)
+    {
+        mixer.sink.write = null_sink_write;
+        mixer.sink.close = null_sink_close;
+    }
+    if (!mixer.sink.write)
+    {
+        fprintf(stderr, "Unknown audio sink %d\n", sink);
+        return 1;
+    }
+
+    mixer.shutdown = 0;
+    if (thread_start(&mixer.thread, mixer_thread, NULL) != 0)
+    {
+        fprintf(stderr, "Cannot start audio thread\n");
+        mixer.sink.close(&mixer.sink);
+        return 1;
+    }
+    mixer.open = 1;
+    return 0;
 }
 
-void arcade_render_text_centered(const char *text, float y, unsigned int color)
+static int push_audio_command(ArcadeAudioCommand cmd)
 {
-    if (!text)
-        return;
-#ifdef _WIN32
-    if (!state.hfont)
-        return;
-    SIZE size;
-    HDC memDC = CreateCompatibleDC(state.hdc);
-    SelectObject(memDC, state.hfont);
-    GetTextExtentPoint32(memDC, text, strlen(text), &size);
-    float x = (state.width - size.cx) / 2.0f;
-    arcade_render_text(text, x, y, color);
-    DeleteDC(memDC);
-#else
-    if (!state.font)
-        return;
-    int text_width = XTextWidth(state.font, text, strlen(text));
-    float x = (state.width - text_width) / 2.0f;
-    arcade_render_text(text, x, y, color);
-#endif
+    /* Caller holds mixer.lock; the mixer consumes without locking */
+    long head = mixer.queue_head;
+    if (head - atomic_load_int(&mixer.queue_tail) >= ARCADE_AUDIO_QUEUE_SIZE)
+        return 1;
+    mixer.queue[head & (ARCADE_AUDIO_QUEUE_SIZE - 1)] = cmd;
+    atomic_store_int(&mixer.queue_head, head + 1);
+    return 0;
 }
 
-void arcade_render_text_centered_blink(const char *text, float y, unsigned int color, int blink_interval)
+static int volume_to_fixed(float volume)
 {
-    if (!text)
-        return;
-    if ((global_frame_counter % (2 * blink_interval)) < blink_interval)
-    {
-        arcade_render_text_centered(text, y, color);
-    }
+    if (volume < 0.0f)
+        volume = 0.0f;
+    if (volume > 4.0f)
+        volume = 4.0f;
+    return (int)(volume * 256.0f + 0.5f);
 }
 
-/* =========================================================================
- * Sprite Groups
- * ========================================================================= */
+int arcade_audio_open(int sink, const char *wav_path)
+{
+    mutex_lock(&mixer.lock);
+    int result = open_audio_locked(sink, wav_path);
+    mutex_unlock(&mixer.lock);
+    return result;
+}
 
-void arcade_init_group(SpriteGroup *group, int capacity)
+void arcade_audio_close(void)
 {
-    group->sprites = malloc(capacity * sizeof(ArcadeAnySprite));
-    group->types = malloc(capacity * sizeof(int));
-    group->count = 0;
-    group->capacity = capacity;
+    mutex_lock(&mixer.lock);
+    close_audio_locked();
+    mutex_unlock(&mixer.lock);
 }
 
-void arcade_add_sprite_to_group(SpriteGroup *group, ArcadeAnySprite sprite, int type)
+static int play_sound_locked(ArcadeSound *sound, float volume, int loop)
 {
-    if (group->count < group->capacity)
+    if (!mixer.open && open_audio_locked(ARCADE_AUDIO_AUTO, NULL) != 0)
+        return 1;
+    atomic_fetch_add_int(&sound->refs, 1); /* Reference handed to the voice */
+    ArcadeAudioCommand cmd = {AUDIO_CMD_PLAY, sound, volume_to_fixed(volume), loop ? 1 : 0};
+    if (push_audio_command(cmd) != 0)
     {
-        group->sprites[group->count] = sprite;
-        group->types[group->count] = type;
-        group->count++;
+        release_sound(sound);
+        fprintf(stderr, "Audio command queue full; sound dropped\n");
+        return 1;
     }
+    return 0;
 }
 
-void arcade_add_animated_to_group(SpriteGroup *group, ArcadeAnimatedSprite *anim)
+int arcade_play_loaded_sound(ArcadeSound *sound, float volume, int loop)
 {
-    if (!anim || !anim->frames[0].active)
-        return;
-    arcade_add_sprite_to_group(group, (ArcadeAnySprite){.image_sprite = anim->frames[anim->current_frame]}, SPRITE_IMAGE);
+    if (!sound)
+        return 1;
+    mutex_lock(&mixer.lock);
+    int result = play_sound_locked(sound, volume, loop);
+    mutex_unlock(&mixer.lock);
+    return result;
 }
 
-void arcade_render_group(SpriteGroup *group)
+int arcade_play_sound(const char *audio_file_path)
+{
+    if (!audio_file_path)
+        return 1;
+    mutex_lock(&mixer.lock);
+    /* Decode each file once; later plays reuse the PCM */
+    ArcadeNamedSound *entry = mixer.named;
+    while (entry && strcmp(entry->path, audio_file_path) != 0)
+        entry = entry->next;
+    if (!entry)
+    {
+        ArcadeSound *sound = arcade_load_sound(audio_file_path);
+        entry = sound ? malloc(sizeof(ArcadeNamedSound)) : NULL;
+        char *path = entry ? malloc(strlen(audio_file_path) + 1) : NULL;
+        if (!path)
+        {
+            free(entry);
+            release_sound(sound);
+            mutex_unlock(&mixer.lock);
+            return 1;
+        }
+        strcpy(path, audio_file_path);
+        entry->path = path;
+        entry->sound = sound;
+        entry->next = mixer.named;
+        mixer.named = entry;
+    }
+    int result = play_sound_locked(entry->sound, 1.0f, 0);
+    mutex_unlock(&mixer.lock);
+    return result;
+}
+
+int arcade_stop_sound(void)
 {
-    arcade_render_scene(group->sprites, group->count, group->types);
+    mutex_lock(&mixer.lock);
+    ArcadeAudioCommand cmd = {AUDIO_CMD_STOP_ALL, NULL, 0, 0};
+    int result = mixer.open ? push_audio_command(cmd) : 0;
+    mutex_unlock(&mixer.lock);
+    return result;
 }
 
-void arcade_free_group(SpriteGroup *group)
+void arcade_set_master_volume(float volume)
 {
-    free(group->sprites);
-    free(group->types);
-    group->count = 0;
-    group->capacity = 0;
+    mutex_lock(&mixer.lock);
+    ArcadeAudioCommand cmd = {AUDIO_CMD_VOLUME, NULL, volume_to_fixed(volume), 0};
+    if (mixer.open)
+        push_audio_command(cmd);
+    else
+        mixer.master_volume = cmd.volume; /* No mixer thread yet; it starts with this value */
+    mutex_unlock(&mixer.lock);
 }
 
 /* =========================================================================
- * Audio
+ * Image Manipulation
  * ========================================================================= */
 
-int arcade_play_sound(const char *audio_file_path)
+void arcade_flip_pixels(uint32_t *pixels, int width, int height, int stride, int flip_type)
 {
-#ifdef _WIN32
-    /* Play WAV file asynchronously using Windows API */
-    return PlaySound(audio_file_path, NULL, SND_FILENAME | SND_ASYNC) ? 0 : 1;
-#else
-    /* Use aplay to play WAV file in the background on Linux */
-    char command[256];
-    snprintf(command, sizeof(command), "aplay -q %s &", audio_file_path); /* Quiet playback in background */
-    return system(command);                                               /* Execute system command and return status */
-#endif
+    if (!pixels || width <= 0 || height <= 0)
+        return;
+    if (stride <= 0)
+        stride = width;
+    if (flip_type != ARCADE_FLIP_VERTICAL)
+    {
+        for (int y = 0; y < height; y++)
+            kernels.reverse(pixels + (size_t)y * stride, pixels + (size_t)y * stride, width);
+        return;
+    }
+    /* Swap rows from both ends towards the middle, a chunk at a time */
+    uint32_t chunk[256];
+    for (int y = 0; y < height / 2; y++)
+    {
+        uint32_t *top = pixels + (size_t)y * stride;
+        uint32_t *bottom = pixels + (size_t)(height - 1 - y) * stride;
+        for (int x = 0; x < width; x += 256)
+        {
+            size_t bytes = (width - x < 256 ? width - x : 256) * sizeof(uint32_t);
+            memcpy(chunk, top + x, bytes);
+            memcpy(top + x, bottom + x, bytes);
+            memcpy(bottom + x, chunk, bytes);
+        }
+    }
 }
 
-int arcade_stop_sound(void)
+int arcade_rotate_pixels(uint32_t *dst, const uint32_t *src, int width, int height, int src_stride, int degrees)
 {
-#ifdef _WIN32
-    /* Stop any currently playing sound using Windows API */
-    return PlaySound(NULL, NULL, 0) ? 0 : 1;
-#else
-    /* Terminate all background aplay processes on Linux */
-    return system("pkill -f 'aplay -q' > /dev/null 2>&1"); /* Kill aplay processes silently */
-#endif
+    /* Clockwise; dst is tightly packed and height x width for 90/270 */
+    degrees = ((degrees % 360) + 360) % 360;
+    if (!dst || !src || width <= 0 || height <= 0 || degrees % 90 != 0)
+        return 1;
+    if (src_stride <= 0)
+        src_stride = width;
+    if (degrees == 90 || degrees == 270)
+    {
+        kernels.rotate(dst, src, width, height, src_stride, degrees == 90);
+        return 0;
+    }
+    for (int y = 0; y < height; y++)
+    {
+        if (degrees == 180)
+            kernels.reverse(dst + (size_t)y * width, src + (size_t)(height - 1 - y) * src_stride, width);
+        else
+            memcpy(dst + (size_t)y * width, src + (size_t)y * src_stride, width * sizeof(uint32_t));
+    }
+    return 0;
 }
 
-/* =========================================================================
- * Image Manipulation
- * ========================================================================= */
+static ArcadeImageSprite transformed_sprite(const ArcadeImageSprite *sprite, ArcadeImageAsset *asset)
+{
+    /* New sprite in the same place as sprite, showing asset (whose reference it takes) */
+    ArcadeImageSprite result = *sprite;
+    result.asset = asset;
+    result.pixels = asset->pixels;
+    result.opaque_rows = asset->opaque_rows;
+    result.image_width = asset->width;
+    result.image_height = asset->height;
+    result.stride = asset->width;
+    result.width = (float)asset->width;
+    result.height = (float)asset->height;
+    return result;
+}
+
+ArcadeImageSprite arcade_flip_sprite(const ArcadeImageSprite *sprite, int flip_type)
+{
+    if (!sprite || !sprite->pixels)
+        return (ArcadeImageSprite){0};
+    int width = sprite->image_width, height = sprite->image_height;
+    int stride = sprite->stride ? sprite->stride : width;
+    ArcadeImageAsset *asset = create_pixel_asset(width, height);
+    if (!asset)
+        return (ArcadeImageSprite){0};
+    /* Mirror while copying rather than copying and then flipping in place */
+    for (int y = 0; y < height; y++)
+    {
+        uint32_t *out = asset->pixels + (size_t)y * width;
+        if (flip_type == ARCADE_FLIP_VERTICAL)
+        {
+            memcpy(out, sprite->pixels + (size_t)(height - 1 - y) * stride, width * sizeof(uint32_t));
+            asset->opaque_rows[y] = sprite->opaque_rows ? sprite->opaque_rows[height - 1 - y] : 0;
+        }
+        else
+        {
+            kernels.reverse(out, sprite->pixels + (size_t)y * stride, width);
+            asset->opaque_rows[y] = sprite->opaque_rows ? sprite->opaque_rows[y] : 0;
+        }
+    }
+    return transformed_sprite(sprite, asset);
+}
+
+ArcadeImageSprite arcade_rotate_sprite(const ArcadeImageSprite *sprite, int degrees)
+{
+    if (!sprite || !sprite->pixels)
+        return (ArcadeImageSprite){0};
+    int quarter = ((degrees % 360) + 360) % 360 / 90 % 2;
+    int width = sprite->image_width, height = sprite->image_height;
+    ArcadeImageAsset *asset = create_pixel_asset(quarter ? height : width, quarter ? width : height);
+    if (!asset)
+        return (ArcadeImageSprite){0};
+    if (arcade_rotate_pixels(asset->pixels, sprite->pixels, width, height, sprite->stride, degrees) != 0)
+    {
+        fprintf(stderr, "Cannot rotate by %d degrees (multiples of 90 only)\n", degrees);
+        release_image_asset(asset);
+        return (ArcadeImageSprite){0};
+    }
+    update_opaque_rows(asset);
+    return transformed_sprite(sprite, asset);
+}
 
 char *arcade_flip_image(const char *input_path, int flip_type)
 {
@@ -1034,36 +6395,8 @@ char *arcade_flip_image(const char *input_path, int flip_type)
         fprintf(stderr, "Memory allocation failed for flipped image\n");
         return NULL;
     }
-    if (flip_type == 1)
-    {
-        for (int y = 0; y < height; y++)
-        {
-            for (int x = 0; x < width; x++)
-            {
-                int src_idx = (height - 1 - y) * width * 4 + x * 4;
-                int dst_idx = y * width * 4 + x * 4;
-                for (int c = 0; c < 4; c++)
-                {
-                    flipped_data[dst_idx + c] = data[src_idx + c];
-                }
-            }
-        }
-    }
-    else
-    {
-        for (int y = 0; y < height; y++)
-        {
-            for (int x = 0; x < width; x++)
-            {
-                int src_idx = y * width * 4 + (width - 1 - x) * 4;
-                int dst_idx = y * width * 4 + x * 4;
-                for (int c = 0; c < 4; c++)
-                {
-                    flipped_data[dst_idx + c] = data[src_idx + c];
-                }
-            }
-        }
-    }
+    memcpy(flipped_data, data, width * height * 4);
+    arcade_flip_pixels((uint32_t *)flipped_data, width, height, width, flip_type == 1 ? ARCADE_FLIP_VERTICAL : ARCADE_FLIP_HORIZONTAL);
 #ifdef _WIN32
     char temp_path[MAX_PATH];
     if (!GetTempFileName(".", "arc", 0, temp_path))
@@ -1154,39 +6487,9 @@ char *arcade_rotate_image(const char *input_path, int degrees)
         fprintf(stderr, "Memory allocation failed for rotated image\n");
         return NULL;
     }
-    for (int y = 0; y < new_height; y++)
-    {
-        for (int x = 0; x < new_width; x++)
-        {
-            int src_x, src_y;
-            if (degrees == 90)
-            {
-                src_x = y;
-                src_y = new_width - 1 - x;
-            }
-            else if (degrees == 180)
-            {
-                src_x = width - 1 - x;
-                src_y = height - 1 - y;
-            }
-            else if (degrees == 270)
-            {
-                src_x = new_height - 1 - y;
-                src_y = x;
-            }
-            else
-            {
-                src_x = x;
-                src_y = y;
-            }
-            int src_idx = src_y * width * 4 + src_x * 4;
-            int dst_idx = y * new_width * 4 + x * 4;
-            for (int c = 0; c < 4; c++)
-            {
-                rotated_data[dst_idx + c] = data[src_idx + c];
-            }
-        }
-    }
+    /* Angles other than 90, 180 and 270 leave the image as it is */
+    int angle = (degrees == 90 || degrees == 180 || degrees == 270) ? degrees : 0;
+    arcade_rotate_pixels((uint32_t *)rotated_data, (const uint32_t *)data, width, height, width, angle);
 #ifdef _WIN32
     char temp_path[MAX_PATH];
     if (!GetTempFileName(".", "arc", 0, temp_path))
@@ -0,0 +1,78 @@
+/* =========================================================================
+ * arcade_pack - Bakes images into an ARCADE asset pack
+ *
+ * Decodes, resizes and premultiplies images ahead of time so a game can open
+ * them with arcade_open_pack instead of decoding PNGs at startup.
+ *
+ * Usage:
+ *   arcade_pack <output.pack> WIDTHxHEIGHT image.png [image.png ...] [WIDTHxHEIGHT image.png ...]
+ * Each size applies to the images that follow it. Images are stored under the
+ * path given on the command line; use the same path in arcade_create_pack_sprite.
+ *
+ * Example:
+ *   arcade_pack game.pack 50x50 assets/player.png assets/enemy.png 16x16 assets/coin.png
+ *
+ * Build (next to the release arcade.h and the STB headers):
+ *   gcc -o arcade_pack tools/arcade_pack.c -Iarcade -lgdi32 -lwinmm # Windows (MinGW)
+ *   gcc -o arcade_pack tools/arcade_pack.c -Iarcade -lX11 -lXext -lm -lpthread -ldl # Linux
+ * ========================================================================= */
+
+#define ARCADE_IMPLEMENTATION
+#include "arcade.h"
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s <output.pack> WIDTHxHEIGHT image [image ...] [WIDTHxHEIGHT image ...]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    int capacity = argc - 2;
+    const char **files = malloc(capacity * sizeof(char *));
+    int *widths = malloc(capacity * sizeof(int));
+    int *heights = malloc(capacity * sizeof(int));
+    if (!files || !widths || !heights)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    int count = 0, width = 0, height = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        int w, h;
+        char end;
+        if (sscanf(argv[i], "%dx%d%c", &w, &h, &end) == 2)
+        {
+            width = w;
+            height = h;
+            continue;
+        }
+        if (width <= 0 || height <= 0)
+        {
+            fprintf(stderr, "No valid size given before %s\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+        files[count] = argv[i];
+        widths[count] = width;
+        heights[count] = height;
+        count++;
+    }
+    if (count == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    int status = arcade_write_pack(argv[1], files, widths, heights, count);
+    if (status == 0)
+        printf("Packed %d image%s into %s\n", count, count == 1 ? "" : "s", argv[1]);
+    free(files);
+    free(widths);
+    free(heights);
+    return status;
+}